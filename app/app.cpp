@@ -1,23 +1,92 @@
 #include "app.h"
 #include "window.h"
+#include "viewport.h"
+#include "../engine/allocation_audit.h"
 
+#include <algorithm>
 #include <iostream>
 #include <exception>
+#include <cmath>
 #include <QTimer>
 #include <QCoreApplication>
+#include <QStringList>
 
 bool DragonApp::init() {
     if (false == initWindow()) {
         return false;
     }
+
+    // --audit-frames N renders continuously without putting the window on
+    // screen, checks that N frames after warm-up make no heap allocations
+    // and exits with a non-zero status if any did.
+    const QStringList args = QCoreApplication::arguments();
+    int auditIdx = args.indexOf("--audit-frames");
+    if (auditIdx >= 0 && auditIdx + 1 < args.size()) {
+        auditFrames = args[auditIdx + 1].toUInt();
+        mainWindow->setAttribute(Qt::WA_DontShowOnScreen);
+    }
     mainWindow->show();
 
-    engine = new Engine(mainWindow->getViewportHWND());
+    // --warp runs on the software adapter; --overlay-stress N fills the stats
+    // HUD with N extra glyphs, renders continuously and exits with a non-zero
+    // status if any frame after warm-up goes over the overlay budget.
+    // The engine starts up in the background, so the window is live while it
+    // does and views are attached once it is ready.
+    engine = new Engine(args.contains("--warp"));
+
+    // --objects N lays out an N object grid to exercise LOD selection, and
+    // --occluders N covers it with N large objects drawn on top for
+    // occlusion culling; --no-occlusion turns the culling off to compare.
+    // --no-bundles re-records every draw each frame instead of replaying
+    // cached bundles, to compare recording cost.
+    int objectsIdx = args.indexOf("--objects");
+    int occludersIdx = args.indexOf("--occluders");
+    if (objectsIdx >= 0 && objectsIdx + 1 < args.size()) {
+        UINT occluders = occludersIdx >= 0 && occludersIdx + 1 < args.size() ? args[occludersIdx + 1].toUInt() : 0;
+        populateObjects(args[objectsIdx + 1].toUInt(), occluders);
+    } else {
+        engine->addObject({0.f, 0.f, 1.f});
+    }
+    engine->setOcclusionCullingEnabled(!args.contains("--no-occlusion"));
+    engine->setDrawBundlesEnabled(!args.contains("--no-bundles"));
+
+    // --world streams the hex-tile world in under the objects; --world-pan
+    // SPEED keeps every view drifting across it at SPEED world units per
+    // second and prints the tiles submitted per second.
+    engine->setWorldEnabled(args.contains("--world"));
+    int panIdx = args.indexOf("--world-pan");
+    if (panIdx >= 0 && panIdx + 1 < args.size()) {
+        worldPanSpeed = args[panIdx + 1].toFloat();
+        engine->setWorldEnabled(true);
+    }
+
+    int stressIdx = args.indexOf("--overlay-stress");
+    if (stressIdx >= 0 && stressIdx + 1 < args.size()) {
+        engine->setOverlayStressGlyphs(args[stressIdx + 1].toUInt());
+        mainWindow->getStatsAction()->setChecked(true);
+        engine->setOverlayEnabled(true);
+        overlayStressFrames = overlayStressCheckedFrames;
+    }
+    attachViewport(mainWindow->getViewport());
+
+    if (auditFrames > 0 || overlayStressFrames > 0) {
+        mainWindow->getAnimateAction()->setChecked(true);
+        engine->requestContinuousRendering();
+    }
+    if (auditFrames > 0) {
+        engine->setOverlayEnabled(true);
+        setAllocationAuditEnabled(true);
+    }
 
     idleTimer = new QTimer(mainWindow);
     connect(idleTimer, &QTimer::timeout, this, &DragonApp::onIdleTick);
     idleTimer->start(0);
 
+    connect(mainWindow->getAnimateAction(), &QAction::toggled, this, &DragonApp::onAnimateToggled);
+    connect(mainWindow->getAddViewAction(), &QAction::triggered, this, &DragonApp::onAddView);
+    connect(mainWindow->getCloseViewAction(), &QAction::triggered, this, &DragonApp::onCloseView);
+    connect(mainWindow->getStatsAction(), &QAction::toggled, this, &DragonApp::onStatsToggled);
+
     fpsTimer = new QTimer(mainWindow);
     connect(fpsTimer, &QTimer::timeout, this, &DragonApp::updateRenderStats);
     fpsTimer->start(1'000);
@@ -28,8 +97,32 @@ bool DragonApp::init() {
 }
 
 void DragonApp::onIdleTick() {
+    if (!pendingViewports.empty() && !attachPendingViewports()) {
+        return;
+    }
+
     try {
-        renderFrame();
+        panWorld();
+
+        bool rendered = renderFrame();
+        if (rendered) {
+            idleTimer->setInterval(0);
+        } else if (engine->hasBackgroundWork()) {
+            idleTimer->setInterval(idleInterval);
+        } else {
+            // Nothing to draw until an event calls wakeRenderLoop().
+            idleTimer->stop();
+        }
+
+        if (rendered && !startupReported) {
+            reportStartup();
+        }
+        if (rendered && auditFrames > 0) {
+            checkAllocationAudit();
+        }
+        if (rendered && overlayStressFrames > 0) {
+            checkOverlayBudget();
+        }
     } catch (std::exception e) {
         std::cerr << "Failed to render frame: " << e.what() << std::endl;
     }
@@ -58,10 +151,266 @@ void DragonApp::onQuit() {
     fpsTimer = nullptr;
 }
 
+void DragonApp::attachViewport(ViewportWidget* viewport) {
+    if (!engine->isReady()) {
+        pendingViewports.push_back(viewport);
+        return;
+    }
+
+    ViewId id = engine->addView(viewport->getNativeWindowHanle());
+    attachedViews.push_back({viewport, id});
+
+    connect(viewport, &ViewportWidget::resized, this, [this, id](UINT width, UINT height) {
+        onViewportResized(id, width, height);
+    });
+    connect(viewport, &ViewportWidget::exposed, this, [this, id]() {
+        onViewportExposed(id);
+    });
+    connect(viewport, &ViewportWidget::zoomed, this, [this, id](float factor) {
+        onViewportZoomed(id, factor);
+    });
+
+    onViewportResized(
+        id,
+        (UINT)(viewport->width() * viewport->devicePixelRatioF()),
+        (UINT)(viewport->height() * viewport->devicePixelRatioF())
+    );
+}
+
+bool DragonApp::attachPendingViewports() {
+    try {
+        if (!engine->isReady()) {
+            idleTimer->setInterval(startupPollInterval);
+            return false;
+        }
+    } catch (std::exception e) {
+        std::cerr << "Engine startup failed: " << e.what() << std::endl;
+        idleTimer->stop();
+        pendingViewports.clear();
+        return false;
+    }
+
+    std::vector<ViewportWidget*> viewports;
+    viewports.swap(pendingViewports);
+    for (ViewportWidget* viewport : viewports) {
+        try {
+            attachViewport(viewport);
+        } catch (std::exception e) {
+            std::cerr << "Failed to add view: " << e.what() << std::endl;
+        }
+    }
+    return true;
+}
+
+void DragonApp::reportStartup() {
+    StartupReport report = engine->getStartupReport();
+
+    std::cout << "Startup: ready after " << report.readyMilliseconds << " ms, first frame after "
+              << report.firstFrameMilliseconds << " ms" << std::endl;
+    for (const TaskGraph::Timing& phase : report.phases) {
+        std::cout << "  " << phase.name << ": " << phase.startMilliseconds << " - " << phase.endMilliseconds
+                  << " ms (" << phase.endMilliseconds - phase.startMilliseconds << " ms, worker "
+                  << phase.worker << ")" << std::endl;
+    }
+
+    startupReported = true;
+}
+
+void DragonApp::checkAllocationAudit() {
+    auditRenderedFrames++;
+    if (auditRenderedFrames <= warmupFrames) return;
+
+    const UINT64 allocations = engine->getFrameAllocationCount();
+    if (allocations > 0) {
+        auditAllocatingFrames++;
+        auditAllocations += allocations;
+    }
+
+    if (auditRenderedFrames < warmupFrames + auditFrames) return;
+
+    std::cout << "Allocation audit: " << auditAllocatingFrames << " of " << auditFrames
+              << " steady-state frames allocated (" << auditAllocations << " allocations)" << std::endl;
+
+    auditFrames = 0;
+    setAllocationAuditEnabled(false);
+    QCoreApplication::exit(auditAllocatingFrames == 0 ? 0 : 1);
+}
+
+void DragonApp::checkOverlayBudget() {
+    overlayStressRenderedFrames++;
+    if (overlayStressRenderedFrames == warmupFrames) {
+        overlayStressBaseline = engine->getOverlayStats().overBudgetFrames;
+    }
+    if (overlayStressRenderedFrames < warmupFrames + overlayStressFrames) return;
+
+    const OverlayStats overlayStats = engine->getOverlayStats();
+    const UINT64 overBudget = overlayStats.overBudgetFrames - overlayStressBaseline;
+    std::cout << "Overlay stress: " << overBudget << " of " << overlayStressFrames << " frames over the "
+              << Engine::overlayBudgetMicroseconds << " us budget (" << overlayStats.quads << " quads)" << std::endl;
+
+    overlayStressFrames = 0;
+    QCoreApplication::exit(overBudget == 0 ? 0 : 1);
+}
+
+void DragonApp::onViewportResized(ViewId id, UINT width, UINT height) {
+    if (engine == nullptr) return;
+
+    try {
+        engine->resizeView(id, width, height);
+    } catch (std::exception e) {
+        std::cerr << "Failed to resize viewport: " << e.what() << std::endl;
+    }
+    wakeRenderLoop();
+}
+
+void DragonApp::onViewportExposed(ViewId id) {
+    if (engine == nullptr) return;
+
+    engine->markDirty(id, DirtyWindow);
+    wakeRenderLoop();
+}
+
+void DragonApp::onViewportZoomed(ViewId id, float factor) {
+    if (engine == nullptr) return;
+
+    Camera camera = engine->getCamera(id);
+    camera.zoom *= factor;
+    engine->setCamera(id, camera);
+    wakeRenderLoop();
+}
+
+void DragonApp::onAddView() {
+    try {
+        attachViewport(mainWindow->addViewport());
+    } catch (std::exception e) {
+        std::cerr << "Failed to add view: " << e.what() << std::endl;
+    }
+    wakeRenderLoop();
+}
+
+void DragonApp::onCloseView() {
+    ViewportWidget* viewport = mainWindow->getLastAddedViewport();
+    if (viewport == nullptr) return;
+
+    pendingViewports.erase(std::remove(pendingViewports.begin(), pendingViewports.end(), viewport), pendingViewports.end());
+
+    // The engine keeps the swap chain until the GPU is done with it, so the
+    // pane can go straight away.
+    auto attached = std::find_if(attachedViews.begin(), attachedViews.end(), [viewport](const AttachedView& view) {
+        return view.viewport == viewport;
+    });
+    if (attached != attachedViews.end()) {
+        engine->removeView(attached->id);
+        attachedViews.erase(attached);
+    }
+
+    mainWindow->closeViewport(viewport);
+    wakeRenderLoop();
+}
+
+void DragonApp::onAnimateToggled(bool checked) {
+    if (checked) {
+        engine->requestContinuousRendering();
+    } else {
+        engine->releaseContinuousRendering();
+    }
+    wakeRenderLoop();
+}
+
+void DragonApp::onStatsToggled(bool checked) {
+    engine->setOverlayEnabled(checked);
+    wakeRenderLoop();
+}
+
+void DragonApp::populateObjects(UINT count, UINT occluders) {
+    const UINT side = (UINT)std::ceil(std::sqrt((double)count));
+    const float spacing = 1.1f;
+    const float origin = -(side - 1) * spacing / 2.f;
+
+    for (UINT i = 0; i < count; i++) {
+        engine->addObject({origin + (i % side) * spacing, origin + (i / side) * spacing, 1.f});
+    }
+
+    if (occluders == 0) return;
+
+    // Added last so they draw over the grid, overlapping their neighbours.
+    const UINT occluderSide = (UINT)std::ceil(std::sqrt((double)occluders));
+    const float occluderSpacing = side * spacing / occluderSide;
+    const float occluderOrigin = -(occluderSide - 1) * occluderSpacing / 2.f;
+
+    for (UINT i = 0; i < occluders; i++) {
+        engine->addObject({
+            occluderOrigin + (i % occluderSide) * occluderSpacing,
+            occluderOrigin + (i / occluderSide) * occluderSpacing,
+            occluderSpacing * 1.5f
+        });
+    }
+}
+
+void DragonApp::panWorld() {
+    if (worldPanSpeed == 0.f || attachedViews.empty()) return;
+
+    auto now = std::chrono::steady_clock::now();
+    if (lastPanTime != std::chrono::steady_clock::time_point{}) {
+        const float offset = worldPanSpeed * std::chrono::duration<float>(now - lastPanTime).count();
+        for (const AttachedView& view : attachedViews) {
+            Camera camera = engine->getCamera(view.id);
+            camera.x += offset;
+            camera.y += offset * 0.5f;
+            engine->setCamera(view.id, camera);
+        }
+    }
+    lastPanTime = now;
+}
+
+void DragonApp::wakeRenderLoop() {
+    if (idleTimer != nullptr) {
+        idleTimer->start(0);
+    }
+}
+
 void DragonApp::updateRenderStats() {
     int frameIdx = engine->getFrameIdx();
+    ViewStats viewStats = engine->getViewStats();
+
+    // Share of one core the whole process used since the last update, the
+    // figure that should drop to almost nothing while idle.
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime);
+    const UINT64 cpuTime =
+        ((UINT64)kernelTime.dwHighDateTime << 32 | kernelTime.dwLowDateTime) +
+        ((UINT64)userTime.dwHighDateTime << 32 | userTime.dwLowDateTime);
+    const auto now = std::chrono::steady_clock::now();
+    if (lastStatsTime != std::chrono::steady_clock::time_point{}) {
+        const double wallTime = std::chrono::duration<double>(now - lastStatsTime).count() * 1e7;
+        mainWindow->setCpuUsage(wallTime > 0.0 ? 100.0 * (cpuTime - lastCpuTime) / wallTime : 0.0);
+    }
+    lastCpuTime = cpuTime;
+    lastStatsTime = now;
 
     mainWindow->setFPS(frameIdx - lastFrameIdx);
+    mainWindow->setViewStats(viewStats.viewCount, viewStats.microsecondsPerView);
+
+    LodStats lodStats = engine->getLodStats();
+    mainWindow->setTriangleStats(lodStats.trianglesSubmitted, lodStats.trianglesSaved);
+
+    OcclusionStats occlusionStats = engine->getOcclusionStats();
+    mainWindow->setOcclusionStats(occlusionStats.rejectedObjects, occlusionStats.testedObjects, occlusionStats.milliseconds);
+
+    WorldStats worldStats = engine->getWorldStats();
+    const UINT64 tilesPerSecond = worldStats.totalTilesSubmitted - lastTilesSubmitted;
+    mainWindow->setWorldStats(tilesPerSecond, (int)worldStats.residentChunks);
+    if (worldPanSpeed != 0.f) {
+        std::cout << "World: " << tilesPerSecond << " tiles/s submitted, " << worldStats.residentChunks
+                  << " chunks resident, " << worldStats.pendingChunks << " loading" << std::endl;
+    }
+    lastTilesSubmitted = worldStats.totalTilesSubmitted;
+
+    OverlayStats overlayStats = engine->getOverlayStats();
+    if (overlayStats.microseconds > Engine::overlayBudgetMicroseconds) {
+        std::cerr << "Overlay over budget: " << overlayStats.quads << " quads took "
+                  << overlayStats.microseconds << " us" << std::endl;
+    }
     lastFrameIdx = frameIdx;
 }
 
@@ -70,6 +419,6 @@ bool DragonApp::initWindow() {
     return mainWindow != nullptr;
 }
 
-void DragonApp::renderFrame() {
-    engine->renderFrame();
+bool DragonApp::renderFrame() {
+    return engine->renderFrame();
 }
@@ -5,6 +5,10 @@
 #include "window.h"
 
 #include <QObject>
+#include <chrono>
+#include <vector>
+
+class ViewportWidget;
 
 class DragonApp : public QObject {
     Q_OBJECT
@@ -17,20 +21,76 @@ public slots:
 
     void onQuit();
 
+    void onAnimateToggled(bool checked);
+    void onAddView();
+    void onCloseView();
+    void onStatsToggled(bool checked);
+
 private:
     bool initWindow();
 
-    void renderFrame();
+    void attachViewport(ViewportWidget* viewport);
+    bool attachPendingViewports();
+    void reportStartup();
+    void checkAllocationAudit();
+    void checkOverlayBudget();
+    void populateObjects(UINT count, UINT occluders);
+    void panWorld();
+
+    void onViewportResized(ViewId id, UINT width, UINT height);
+    void onViewportExposed(ViewId id);
+    void onViewportZoomed(ViewId id, float factor);
+
+    bool renderFrame();
+    void wakeRenderLoop();
 
     void updateRenderStats();
 
 private:
-    Engine* engine;
-    DragonMainWindow* mainWindow;
+    Engine* engine = nullptr;
+    DragonMainWindow* mainWindow = nullptr;
 
     QTimer* idleTimer = nullptr;
     QTimer* fpsTimer = nullptr;
     int lastFrameIdx = 0;
+    // Process CPU time, in 100 ns units, and when it was read.
+    UINT64 lastCpuTime = 0;
+    std::chrono::steady_clock::time_point lastStatsTime{};
+    UINT64 lastTilesSubmitted = 0;
+
+    struct AttachedView {
+        ViewportWidget* viewport;
+        ViewId id;
+    };
+    std::vector<AttachedView> attachedViews;
+
+    // World units per second every view drifts by; 0 when off.
+    float worldPanSpeed = 0.f;
+    std::chrono::steady_clock::time_point lastPanTime{};
+
+    // Viewports created before the engine finished starting up.
+    std::vector<ViewportWidget*> pendingViewports;
+    bool startupReported = false;
+
+    // Frames to audit for heap allocations after warming up; 0 when off.
+    UINT auditFrames = 0;
+    UINT auditRenderedFrames = 0;
+    UINT auditAllocatingFrames = 0;
+    UINT64 auditAllocations = 0;
+
+    // Frames to check against the overlay budget after warming up; 0 when off.
+    UINT overlayStressFrames = 0;
+    UINT overlayStressRenderedFrames = 0;
+    UINT64 overlayStressBaseline = 0;
+    static const UINT overlayStressCheckedFrames = 600;
+
+    // Frames rendered before the audit and the overlay check start counting.
+    static const UINT warmupFrames = 120;
+
+    // Poll interval while nothing is drawn but the engine still has
+    // background work; with none the loop sleeps until woken.
+    static const int idleInterval = 16;
+    static const int startupPollInterval = 1;
 };
 
 #endif
@@ -7,6 +7,8 @@ int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
     DragonApp app;
-    assert(app.init());
+    if (!app.init()) {
+        return 1;
+    }
     return a.exec();
 }
@@ -25,8 +25,18 @@ public:
     QWidget* centralWidget;
     QGridLayout* mainLayout;
     ViewportWidget* viewport;
+    QToolBar* toolBar;
+    QAction* actionAnimate;
+    QAction* actionAddView;
+    QAction* actionCloseView;
+    QAction* actionStats;
     QStatusBar* statusBar;
     QLabel* statusFPS;
+    QLabel* statusCpu;
+    QLabel* statusViews;
+    QLabel* statusTriangles;
+    QLabel* statusOcclusion;
+    QLabel* statusTiles;
 
     void setupUi(QMainWindow* Notepad)
     {
@@ -48,6 +58,28 @@ public:
         viewport->setObjectName("viewport");
         mainLayout->addWidget(viewport, 0, 0);
 
+        toolBar = new QToolBar(Notepad);
+        toolBar->setObjectName("toolBar");
+        Notepad->addToolBar(toolBar);
+
+        actionAnimate = new QAction(Notepad);
+        actionAnimate->setObjectName("actionAnimate");
+        actionAnimate->setCheckable(true);
+        toolBar->addAction(actionAnimate);
+
+        actionAddView = new QAction(Notepad);
+        actionAddView->setObjectName("actionAddView");
+        toolBar->addAction(actionAddView);
+
+        actionCloseView = new QAction(Notepad);
+        actionCloseView->setObjectName("actionCloseView");
+        toolBar->addAction(actionCloseView);
+
+        actionStats = new QAction(Notepad);
+        actionStats->setObjectName("actionStats");
+        actionStats->setCheckable(true);
+        toolBar->addAction(actionStats);
+
         // Real status bar
         statusBar = new QStatusBar(Notepad);
         statusBar->setObjectName("statusbar");
@@ -56,6 +88,26 @@ public:
         statusFPS = new QLabel(statusBar);
         statusFPS->setObjectName("statusFPS");
         statusBar->addPermanentWidget(statusFPS); // stays on the right
+
+        statusCpu = new QLabel(statusBar);
+        statusCpu->setObjectName("statusCpu");
+        statusBar->addPermanentWidget(statusCpu);
+
+        statusViews = new QLabel(statusBar);
+        statusViews->setObjectName("statusViews");
+        statusBar->addPermanentWidget(statusViews);
+
+        statusTriangles = new QLabel(statusBar);
+        statusTriangles->setObjectName("statusTriangles");
+        statusBar->addPermanentWidget(statusTriangles);
+
+        statusOcclusion = new QLabel(statusBar);
+        statusOcclusion->setObjectName("statusOcclusion");
+        statusBar->addPermanentWidget(statusOcclusion);
+
+        statusTiles = new QLabel(statusBar);
+        statusTiles->setObjectName("statusTiles");
+        statusBar->addPermanentWidget(statusTiles);
         // or: statusBar->addWidget(statusFPS);    // on the left
 
         retranslateUi(Notepad);
@@ -65,7 +117,16 @@ public:
     void retranslateUi(QMainWindow* Notepad)
     {
         Notepad->setWindowTitle(QCoreApplication::translate("Notepad", "Notepad", nullptr));
+        actionAnimate->setText(QCoreApplication::translate("Notepad", "Animate", nullptr));
+        actionAddView->setText(QCoreApplication::translate("Notepad", "Add view", nullptr));
+        actionCloseView->setText(QCoreApplication::translate("Notepad", "Close view", nullptr));
+        actionStats->setText(QCoreApplication::translate("Notepad", "Stats", nullptr));
         statusFPS->setText(QCoreApplication::translate("Notepad", "FPS: 0", nullptr));
+        statusCpu->setText(QCoreApplication::translate("Notepad", "CPU: 0.0%", nullptr));
+        statusViews->setText(QCoreApplication::translate("Notepad", "Views: 1", nullptr));
+        statusTriangles->setText(QCoreApplication::translate("Notepad", "Tris: 0", nullptr));
+        statusOcclusion->setText(QCoreApplication::translate("Notepad", "Occluded: 0%", nullptr));
+        statusTiles->setText(QCoreApplication::translate("Notepad", "Tiles/s: 0", nullptr));
     }
 };
 
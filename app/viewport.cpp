@@ -1,5 +1,8 @@
 #include "viewport.h"
 #include <QPainter>
+#include <QResizeEvent>
+#include <QWheelEvent>
+#include <cmath>
 
 
 ViewportWidget::ViewportWidget(QWidget* parent) : QWidget(parent) {
@@ -14,4 +17,22 @@ HWND ViewportWidget::getNativeWindowHanle() {
 void ViewportWidget::paintEvent(QPaintEvent* event) {
     QPainter painter(this);
     painter.drawImage(rect(), image);
+
+    emit exposed();
+}
+
+void ViewportWidget::resizeEvent(QResizeEvent* event) {
+    QWidget::resizeEvent(event);
+
+    const qreal ratio = devicePixelRatioF();
+    emit resized(
+        (UINT)(event->size().width() * ratio),
+        (UINT)(event->size().height() * ratio)
+    );
+}
+
+void ViewportWidget::wheelEvent(QWheelEvent* event) {
+    // One notch (120 units) zooms by roughly 20%.
+    emit zoomed(std::pow(1.0015f, (float)event->angleDelta().y()));
+    event->accept();
 }
@@ -10,8 +10,16 @@ public:
     ViewportWidget(QWidget* parent = nullptr);
 
     HWND getNativeWindowHanle();
+
+signals:
+    void resized(UINT width, UINT height);
+    void exposed();
+    void zoomed(float factor);
+
 protected:
     void paintEvent(QPaintEvent* event) override;
+    void resizeEvent(QResizeEvent* event) override;
+    void wheelEvent(QWheelEvent* event) override;
 
 private:
     QImage image;
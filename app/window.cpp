@@ -1,5 +1,6 @@
 #include "window.h"
 #include "ui_app.h"
+#include "viewport.h"
 
 #include <QFileDialog>
 #include <QMessageBox>
@@ -21,6 +22,82 @@ void DragonMainWindow::setFPS(const int fps) {
     ui->statusFPS->setText(QString::number(fps));
 }
 
+void DragonMainWindow::setCpuUsage(const double percent) {
+    ui->statusCpu->setText("CPU: " + QString::number(percent, 'f', 1) + "%");
+}
+
+void DragonMainWindow::setViewStats(const int views, const double microsecondsPerView) {
+    ui->statusViews->setText(
+        "Views: " + QString::number(views) +
+        " (" + QString::number(microsecondsPerView, 'f', 1) + " us/view)"
+    );
+}
+
+void DragonMainWindow::setTriangleStats(const qulonglong submitted, const qulonglong saved) {
+    ui->statusTriangles->setText(
+        "Tris: " + QString::number(submitted) +
+        " (saved " + QString::number(saved) + ")"
+    );
+}
+
+void DragonMainWindow::setOcclusionStats(const qulonglong rejected, const qulonglong tested, const double milliseconds) {
+    const double percent = tested > 0 ? 100.0 * rejected / tested : 0.0;
+    ui->statusOcclusion->setText(
+        "Occluded: " + QString::number(percent, 'f', 1) + "%" +
+        " (" + QString::number(milliseconds, 'f', 3) + " ms)"
+    );
+}
+
+void DragonMainWindow::setWorldStats(const qulonglong tilesPerSecond, const int residentChunks) {
+    ui->statusTiles->setText(
+        "Tiles/s: " + QString::number(tilesPerSecond) +
+        " (" + QString::number(residentChunks) + " chunks)"
+    );
+}
+
 HWND DragonMainWindow::getViewportHWND() {
     return ui->viewport->getNativeWindowHanle();
 }
+
+
+ViewportWidget* DragonMainWindow::getViewport() {
+    return ui->viewport;
+}
+
+ViewportWidget* DragonMainWindow::addViewport() {
+    // Panes are laid out left to right in a single row.
+    ViewportWidget* viewport = new ViewportWidget(ui->centralWidget);
+    viewport->setObjectName("viewport" + QString::number(ui->mainLayout->count()));
+    ui->mainLayout->addWidget(viewport, 0, ui->mainLayout->columnCount());
+    viewport->show();
+
+    return viewport;
+}
+
+ViewportWidget* DragonMainWindow::getLastAddedViewport() {
+    const int count = ui->mainLayout->count();
+    if (count <= 1) return nullptr;
+
+    return qobject_cast<ViewportWidget*>(ui->mainLayout->itemAt(count - 1)->widget());
+}
+
+void DragonMainWindow::closeViewport(ViewportWidget* viewport) {
+    ui->mainLayout->removeWidget(viewport);
+    viewport->deleteLater();
+}
+
+QAction* DragonMainWindow::getAnimateAction() {
+    return ui->actionAnimate;
+}
+
+QAction* DragonMainWindow::getAddViewAction() {
+    return ui->actionAddView;
+}
+
+QAction* DragonMainWindow::getCloseViewAction() {
+    return ui->actionCloseView;
+}
+
+QAction* DragonMainWindow::getStatsAction() {
+    return ui->actionStats;
+}
@@ -2,6 +2,9 @@
 #define WINDOW_H
 
 #include <QMainWindow>
+#include <QAction>
+
+class ViewportWidget;
 
 QT_BEGIN_NAMESPACE
 namespace Ui {
@@ -18,8 +21,23 @@ public:
     ~DragonMainWindow();
 
     void setFPS(const int fps);
+    void setCpuUsage(const double percent);
+    void setViewStats(const int views, const double microsecondsPerView);
+    void setTriangleStats(const qulonglong submitted, const qulonglong saved);
+    void setOcclusionStats(const qulonglong rejected, const qulonglong tested, const double milliseconds);
+    void setWorldStats(const qulonglong tilesPerSecond, const int residentChunks);
 
     HWND getViewportHWND();
+    ViewportWidget* getViewport();
+    ViewportWidget* addViewport();
+    // The most recently added pane still open; the first pane is never
+    // returned.
+    ViewportWidget* getLastAddedViewport();
+    void closeViewport(ViewportWidget* viewport);
+    QAction* getAnimateAction();
+    QAction* getAddViewAction();
+    QAction* getCloseViewAction();
+    QAction* getStatsAction();
 
     // void closeEvent(QCloseEvent* event);
 
@@ -0,0 +1,148 @@
+#include "allocation_audit.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<bool> auditEnabled = false;
+std::atomic<uint64_t> allocationCount = 0;
+thread_local bool auditedThread = false;
+
+void* allocate(size_t size) {
+    if (auditEnabled.load(std::memory_order_relaxed) && auditedThread) {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void* allocateAligned(size_t size, std::align_val_t alignment) {
+    if (auditEnabled.load(std::memory_order_relaxed) && auditedThread) {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+    }
+#ifdef _MSC_VER
+    return _aligned_malloc(size == 0 ? 1 : size, (size_t)alignment);
+#else
+    const size_t align = (size_t)alignment;
+    return std::aligned_alloc(align, ((size == 0 ? 1 : size) + align - 1) / align * align);
+#endif
+}
+
+void freeAligned(void* ptr) {
+#ifdef _MSC_VER
+    _aligned_free(ptr);
+#else
+    std::free(ptr);
+#endif
+}
+
+}
+
+void setAllocationAuditEnabled(bool enabled) {
+    if (enabled) {
+        auditedThread = true;
+        allocationCount = 0;
+    }
+    auditEnabled = enabled;
+}
+
+bool isAllocationAuditEnabled() {
+    return auditEnabled;
+}
+
+void auditAllocationsOnThisThread() {
+    auditedThread = true;
+}
+
+uint64_t getAllocationCount() {
+    return allocationCount;
+}
+
+void* operator new(size_t size) {
+    void* ptr = allocate(size);
+    if (ptr == nullptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new[](size_t size) {
+    void* ptr = allocate(size);
+    if (ptr == nullptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    void* ptr = allocateAligned(size, alignment);
+    if (ptr == nullptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+    void* ptr = allocateAligned(size, alignment);
+    if (ptr == nullptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocateAligned(size, alignment);
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocateAligned(size, alignment);
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+    freeAligned(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept {
+    freeAligned(ptr);
+}
+
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept {
+    freeAligned(ptr);
+}
+
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept {
+    freeAligned(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept {
+    freeAligned(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept {
+    freeAligned(ptr);
+}
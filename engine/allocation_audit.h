@@ -0,0 +1,20 @@
+#ifndef ALLOCATION_AUDIT_H_
+#define ALLOCATION_AUDIT_H_
+
+#include <cstdint>
+
+// Global operator new is replaced to count heap allocations made by the
+// engine and app while auditing is enabled. Counting costs one relaxed
+// atomic load per allocation when it is off.
+//
+// Only threads doing frame work are counted: the one that enables the
+// audit and any that opt in. Background threads such as the world loaders
+// allocate on their own schedule and would otherwise be charged to
+// whichever frame happens to be running.
+void setAllocationAuditEnabled(bool enabled);
+bool isAllocationAuditEnabled();
+void auditAllocationsOnThisThread();
+// Allocations on audited threads since auditing was last enabled.
+uint64_t getAllocationCount();
+
+#endif
@@ -0,0 +1,12 @@
+#ifndef CAMERA_H_
+#define CAMERA_H_
+
+// 2D camera: the view is centred on (x, y) and world units are scaled by
+// zoom. One world unit spans half of the view height at zoom 1.
+struct Camera {
+    float x = 0.f;
+    float y = 0.f;
+    float zoom = 1.f;
+};
+
+#endif
@@ -1,12 +1,23 @@
 #include "engine.h"
 #include "types.h"
+#include "mesh.h"
+#include "vertex_pack.h"
+#include "frame_arena.h"
+#include "allocation_audit.h"
 #include "const_color_vs.h"
 #include "const_color_ps.h"
+#include "hex_tile_vs.h"
+#include "hex_tile_ps.h"
 
 #include <iostream>
 #include <fstream>
 #include <numbers>
 #include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <limits>
 #include <wrl.h>
 #include <dxgi1_6.h>
 #include <d3d12.h>
@@ -17,9 +28,26 @@
 #pragma comment(lib, "d3d12.lib")
 #pragma comment(lib, "d3dcompiler.lib")
 
-Engine::Engine() {}
+namespace {
 
-Engine::Engine(HWND hwnd) : hwnd(hwnd) {
+void addStats(LodStats& total, const LodStats& stats) {
+    total.drawnObjects += stats.drawnObjects;
+    for (UINT i = 0; i < LodStats::maxLevels; i++) {
+        total.objectsPerLevel[i] += stats.objectsPerLevel[i];
+    }
+    total.trianglesSubmitted += stats.trianglesSubmitted;
+    total.trianglesSaved += stats.trianglesSaved;
+}
+
+void addStats(OcclusionStats& total, const OcclusionStats& stats) {
+    total.occluders += stats.occluders;
+    total.testedObjects += stats.testedObjects;
+    total.rejectedObjects += stats.rejectedObjects;
+}
+
+}
+
+Engine::Engine(bool useWarpAdapter) : useWarpAdapter(useWarpAdapter) {
 #ifdef _DEBUG
     // Enable the D3D12 debug layer.
     ID3D12Debug* debugController;
@@ -30,46 +58,252 @@ Engine::Engine(HWND hwnd) : hwnd(hwnd) {
         std::cout << "Failed to enable debug interface\n";
     }
 #endif
-    prepareForRendering();
+    workerPool = std::make_unique<ThreadPool>(std::clamp(std::thread::hardware_concurrency(), 1u, 8u));
+
+    startupBegin = std::chrono::steady_clock::now();
+    startupThread = std::thread([this] {
+        try {
+            prepareForRendering();
+        } catch (...) {
+            startupError = std::current_exception();
+        }
+        startupReport.readyMilliseconds = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - startupBegin
+        ).count();
+        startupFinished.store(true, std::memory_order_release);
+    });
 }
 
 Engine::~Engine() {
+    if (startupThread.joinable()) {
+        startupThread.join();
+    }
+
+    // Loader threads stop before the rest of the engine goes away.
+    world.reset();
+
+    // Submissions complete in order, so once the last one is done
+    // everything retired before it is too.
+    if (fence != nullptr && fenceEvent != nullptr) {
+        waitForFence(submittedFenceValue);
+    }
+    releaseQueue.releaseAll();
     if (fenceEvent) {
         CloseHandle(fenceEvent);
         fenceEvent = nullptr;
     }
 }
 
+bool Engine::isReady() {
+    if (startupThread.joinable()) {
+        if (!startupFinished.load(std::memory_order_acquire)) return false;
+        startupThread.join();
+    }
+
+    if (startupError) {
+        std::rethrow_exception(startupError);
+    }
+    return true;
+}
+
+StartupReport Engine::getStartupReport() {
+    if (!isReady()) return {};
+    return startupReport;
+}
+
 int Engine::getFrameIdx() {
     return frameIdx;
 }
 
-void Engine::prepareForRendering() {
-    createDevice();
+bool Engine::hasBackgroundWork() {
+    if (!isReady()) return false;
 
-    createCommandsManagers();
+    return !releaseQueue.isEmpty() || worldStats.pendingChunks > 0;
+}
 
-    createSwapChain();
-    createRenderTargetView();
+ViewStats Engine::getViewStats() {
+    return viewStats;
+}
+
+OverlayStats Engine::getOverlayStats() {
+    return overlayStats;
+}
 
-    createBarriers();
-    createFence();
+void Engine::setOverlayEnabled(bool enabled) {
+    if (enabled == overlayEnabled) return;
 
-    createVertexBuffer();
-    uploadVertexData();
+    overlayEnabled = enabled;
 
-    createRootSignature();
-    createPipelineState();
-    createVpAndSc();
+    View* view = primaryView();
+    if (view != nullptr) {
+        view->addDamage(overlayBounds);
+        view->markDirty(DirtyScene);
+    }
+    overlayBounds = {};
 }
 
-void Engine::createDevice() {
-    HRESULT hr;
+void Engine::setOverlayStressGlyphs(UINT count) {
+    overlayStressGlyphs = count;
+}
+
+void Engine::setOcclusionCullingEnabled(bool enabled) {
+    occlusionCullingEnabled = enabled;
+    sceneVersion++;
+}
+
+void Engine::setDrawBundlesEnabled(bool enabled) {
+    drawBundlesEnabled = enabled;
+}
+
+ViewId Engine::addView(HWND hwnd) {
+    if (!isReady()) {
+        throw std::runtime_error("engine is still starting up");
+    }
+
+    auto view = std::make_unique<View>(dxgiFactory.Get(), device.Get(), commandQueue.Get(), hwnd);
+
+    for (ViewId id = 0; id < views.size(); id++) {
+        if (views[id] == nullptr) {
+            views[id] = std::move(view);
+            return id;
+        }
+    }
+
+    views.push_back(std::move(view));
+    return (ViewId)(views.size() - 1);
+}
+
+void Engine::removeView(ViewId id) {
+    if (id >= views.size() || views[id] == nullptr) return;
+
+    // The swap chain and back buffers go once the last frame that drew
+    // into them is done.
+    std::shared_ptr<View> view = std::move(views[id]);
+    const UINT64 lastUsed = view->getLastUsedFence();
+
+    auto bundle = drawBundles.find(view.get());
+    if (bundle != drawBundles.end()) {
+        for (BundleBuffer& buffer : bundle->second.buffers) {
+            if (buffer.commandList == nullptr) continue;
+            releaseQueue.retire(std::move(buffer.commandList), lastUsed);
+            releaseQueue.retire(std::move(buffer.allocator), lastUsed);
+        }
+        drawBundles.erase(bundle);
+    }
+
+    releaseQueue.defer([view] {}, lastUsed);
+}
+
+View* Engine::findView(ViewId id) {
+    return id < views.size() ? views[id].get() : nullptr;
+}
+
+// Window events can still arrive for a view that was just closed, so
+// changes to a removed view are ignored.
+void Engine::resizeView(ViewId id, UINT width, UINT height) {
+    View* found = findView(id);
+    if (found == nullptr) return;
+
+    View& view = *found;
+    if (width == view.getWidth() && height == view.getHeight()) return;
+
+    // ResizeBuffers needs the back buffers idle, which only takes the last
+    // frame this view was in, not a full drain.
+    waitForFence(view.getLastUsedFence());
+    view.resize(width, height);
+}
 
-    hr = CreateDXGIFactory1(IID_PPV_ARGS(dxgiFactory.GetAddressOf()));
+void Engine::setCamera(ViewId id, const Camera& camera) {
+    if (View* view = findView(id)) {
+        view->setCamera(camera);
+    }
+}
+
+const Camera& Engine::getCamera(ViewId id) {
+    View* view = findView(id);
+    if (view == nullptr) {
+        throw std::runtime_error("view has been removed");
+    }
+    return view->getCamera();
+}
+
+void Engine::markDirty(UINT flags) {
+    for (auto& view : views) {
+        if (view != nullptr) {
+            view->markDirty(flags);
+        }
+    }
+}
+
+void Engine::markDirty(ViewId id, UINT flags) {
+    if (View* view = findView(id)) {
+        view->markDirty(flags);
+    }
+}
+
+void Engine::requestContinuousRendering() {
+    continuousRequests++;
+}
+
+void Engine::releaseContinuousRendering() {
+    if (continuousRequests > 0) {
+        continuousRequests--;
+    }
+}
+
+void Engine::prepareForRendering() {
+    // The device is free-threaded, so everything that only needs it runs in
+    // parallel. The command list is not: the overlay atlas copy and the
+    // geometry upload are recorded one after the other.
+    TaskGraph startup;
+
+    auto factoryTask = startup.add("factory", [this] { createFactory(); });
+    auto deviceTask = startup.add("adapter and device", [this] { createDevice(); }, {factoryTask});
+    auto geometryTask = startup.add("lod geometry", [this] { buildHexagonLods(); });
+    auto commandsTask = startup.add("command queue", [this] { createCommandsManagers(); }, {deviceTask});
+    auto fenceTask = startup.add("fence", [this] { createFence(); }, {deviceTask});
+    auto rootSignatureTask = startup.add("root signature", [this] { createRootSignature(); }, {deviceTask});
+    startup.add("pipeline state", [this] { createPipelineState(); }, {rootSignatureTask});
+    startup.add("world pipeline state", [this] { createWorldPipelineState(); }, {rootSignatureTask});
+    auto overlayTask = startup.add("overlay", [this] { createOverlay(); }, {commandsTask});
+    auto buffersTask = startup.add("vertex buffers", [this] { createVertexBuffer(); }, {deviceTask, geometryTask});
+    startup.add("asset upload", [this] { uploadVertexData(); }, {buffersTask, overlayTask, fenceTask});
+
+    const unsigned workers = std::clamp(std::thread::hardware_concurrency(), 2u, 4u);
+    startup.run(workers);
+
+    startupReport.phases = startup.getTimings();
+}
+
+void Engine::createFactory() {
+    HRESULT hr = CreateDXGIFactory1(IID_PPV_ARGS(dxgiFactory.GetAddressOf()));
     if (FAILED(hr)) {
         throw std::runtime_error("failed to create device factory");
     }
+}
+
+void Engine::createDevice() {
+    HRESULT hr;
+
+    if (useWarpAdapter) {
+        Microsoft::WRL::ComPtr<IDXGIAdapter1> adapter;
+        hr = dxgiFactory->EnumWarpAdapter(IID_PPV_ARGS(adapter.GetAddressOf()));
+        if (FAILED(hr)) {
+            throw std::runtime_error("failed to get WARP adapter");
+        }
+
+        hr = D3D12CreateDevice(
+            adapter.Get(),
+            D3D_FEATURE_LEVEL_12_0,
+            IID_PPV_ARGS(device.GetAddressOf())
+        );
+        if (FAILED(hr)) {
+            throw std::runtime_error("failed to create WARP device");
+        }
+
+        std::wcout << L"Using: WARP" << std::endl;
+        return;
+    }
 
     for (UINT i = 0; ; ++i) {
         Microsoft::WRL::ComPtr<IDXGIAdapter1> adapter;
@@ -114,12 +348,14 @@ void Engine::createCommandsManagers() {
         throw std::runtime_error("failed to crerate command queue");
     }
 
-    hr = device->CreateCommandAllocator(queueDesc.Type, IID_PPV_ARGS(commandAllocator.GetAddressOf()));
-    if (FAILED(hr)) {
-        throw std::runtime_error("failed to crerate command allocator");
+    for (auto& allocator : commandAllocators) {
+        hr = device->CreateCommandAllocator(queueDesc.Type, IID_PPV_ARGS(allocator.GetAddressOf()));
+        if (FAILED(hr)) {
+            throw std::runtime_error("failed to crerate command allocator");
+        }
     }
 
-    hr = device->CreateCommandList(0, queueDesc.Type, commandAllocator.Get(), nullptr, IID_PPV_ARGS(commandList.GetAddressOf()));
+    hr = device->CreateCommandList(0, queueDesc.Type, commandAllocators[0].Get(), nullptr, IID_PPV_ARGS(commandList.GetAddressOf()));
     if (FAILED(hr)) {
         throw std::runtime_error("failed to crerate command list");
     }
@@ -128,89 +364,17 @@ void Engine::createCommandsManagers() {
         throw std::runtime_error("failed to reset command allocator");
     }
 
-    hr = commandAllocator->Reset();
+    hr = commandAllocators[0]->Reset();
     if (FAILED(hr)) {
         throw std::runtime_error("failed to reset command allocator");
     }
 
-    hr = commandList->Reset(commandAllocator.Get(), nullptr);
+    hr = commandList->Reset(commandAllocators[0].Get(), nullptr);
     if (FAILED(hr)) {
         throw std::runtime_error("failed to reset command allocator");
     }
 }
 
-void Engine::createSwapChain() {
-    HRESULT hr;
-
-    swapChainDesc.Width = width;
-    swapChainDesc.Height = height;
-    swapChainDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-    swapChainDesc.BufferCount = bufferCount;
-    swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
-    swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
-    swapChainDesc.SampleDesc.Count = 1;
-
-    ComPtr<IDXGISwapChain1> swapChain1;
-    hr = dxgiFactory->CreateSwapChainForHwnd(
-        commandQueue.Get(),
-        hwnd,
-        &swapChainDesc,
-        nullptr,
-        nullptr,
-        swapChain1.GetAddressOf()
-    );
-    if (FAILED(hr)) {
-        throw std::runtime_error("failed to create swap chain");
-    }
-    dxgiFactory->MakeWindowAssociation(hwnd, DXGI_MWA_NO_ALT_ENTER);
-
-    hr = swapChain1.As(&swapChain);
-    if (FAILED(hr)) {
-        throw std::runtime_error("failed to query IDXGISwapChain3");
-    }
-}
-
-void Engine::createRenderTargetView() {
-    HRESULT hr;
-
-    D3D12_DESCRIPTOR_HEAP_DESC descrHeapDesc{};
-    descrHeapDesc.NumDescriptors = bufferCount;
-    descrHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
-
-    hr = device->CreateDescriptorHeap(&descrHeapDesc, IID_PPV_ARGS(rtvHeap.GetAddressOf()));
-    if (FAILED(hr)) {
-        throw std::runtime_error("failed to create descriptor heap");
-    }
-
-    UINT rtvStride = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
-    D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = rtvHeap->GetCPUDescriptorHandleForHeapStart();
-
-    for (UINT i = 0; i < bufferCount; ++ i) {
-        hr = swapChain->GetBuffer(i, IID_PPV_ARGS(backBuffers[i].GetAddressOf()));
-        if (FAILED(hr)) {
-            throw std::runtime_error("failed to get back buffer");
-        }
-        device->CreateRenderTargetView(backBuffers[i].Get(), nullptr, rtvHandle);
-
-        this->rtvHandle[i] = rtvHandle;
-        rtvHandle.ptr += rtvStride;
-    }
-}
-
-void Engine::createBarriers() {
-    for (UINT i = 0; i < bufferCount; i++) {
-        presentToRTVBarrier[i] = {};
-        presentToRTVBarrier[i].Transition.pResource   = backBuffers[i].Get();
-        presentToRTVBarrier[i].Transition.StateBefore = D3D12_RESOURCE_STATE_PRESENT;
-        presentToRTVBarrier[i].Transition.StateAfter  = D3D12_RESOURCE_STATE_RENDER_TARGET;
-
-        rtvToPresentBarrier[i] = {};
-        rtvToPresentBarrier[i].Transition.pResource   = backBuffers[i].Get();
-        rtvToPresentBarrier[i].Transition.StateBefore = D3D12_RESOURCE_STATE_RENDER_TARGET;
-        rtvToPresentBarrier[i].Transition.StateAfter  = D3D12_RESOURCE_STATE_PRESENT;
-    }
-}
-
 void Engine::createFence() {
     HRESULT hr;
 
@@ -226,6 +390,14 @@ void Engine::createFence() {
 }
 
 void Engine::createVertexBuffer() {
+    UINT vertexCount = 0, indexCount = 0;
+    for (const LodLevel& level : hexagonLodChain) {
+        vertexCount += (UINT)level.mesh.vertices.size();
+        indexCount += (UINT)level.mesh.indices.size();
+    }
+    const UINT vertexBytes = vertexCount * sizeof(PackedVertex);
+    const UINT indexBytes = indexCount * sizeof(uint32_t);
+
     D3D12_HEAP_PROPERTIES defaultHeapProps{};
     defaultHeapProps.Type = D3D12_HEAP_TYPE_DEFAULT;
 
@@ -234,7 +406,7 @@ void Engine::createVertexBuffer() {
 
     D3D12_RESOURCE_DESC bufDesc{};
     bufDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
-    bufDesc.Width = sizeof(triangles);
+    bufDesc.Width = vertexBytes + indexBytes;
     bufDesc.Height = 1;
     bufDesc.DepthOrArraySize = 1;
     bufDesc.MipLevels = 1;
@@ -253,6 +425,7 @@ void Engine::createVertexBuffer() {
         throw std::runtime_error("failed to create upload buffer");
     }
 
+    bufDesc.Width = vertexBytes;
     hr = device->CreateCommittedResource(
         &defaultHeapProps,
         D3D12_HEAP_FLAG_NONE,
@@ -265,33 +438,89 @@ void Engine::createVertexBuffer() {
         throw std::runtime_error("failed to create vertex buffer");
     }
 
+    bufDesc.Width = indexBytes;
+    hr = device->CreateCommittedResource(
+        &defaultHeapProps,
+        D3D12_HEAP_FLAG_NONE,
+        &bufDesc,
+        D3D12_RESOURCE_STATE_COPY_DEST,
+        nullptr,
+        IID_PPV_ARGS(indexBuffer.GetAddressOf())
+    );
+    if (FAILED(hr)) {
+        throw std::runtime_error("failed to create index buffer");
+    }
+
     vertexView.BufferLocation = vertexBuffer->GetGPUVirtualAddress();
-    vertexView.StrideInBytes = sizeof(Vertex);
-    vertexView.SizeInBytes = sizeof(triangles);
+    vertexView.StrideInBytes = PackedVertex::Layout::stride;
+    vertexView.SizeInBytes = vertexBytes;
+
+    indexView.BufferLocation = indexBuffer->GetGPUVirtualAddress();
+    indexView.Format = DXGI_FORMAT_R32_UINT;
+    indexView.SizeInBytes = indexBytes;
 }
 
-void Engine::uploadVertexData() {
-    generateHexagon(0.5);
+void Engine::buildHexagonLods() {
+    hexagonLodChain = buildLodChain(generateHexagon(hexagonRadius, hexagonDetail), lodErrorThresholds);
+    if (hexagonLodChain.size() > LodStats::maxLevels) {
+        hexagonLodChain.resize(LodStats::maxLevels);
+    }
 
-    void* mapped = nullptr;
+    hexagonLods.clear();
+    UINT baseVertex = 0, firstIndex = 0;
+    for (const LodLevel& level : hexagonLodChain) {
+        MeshLod lod{};
+        lod.baseVertex = baseVertex;
+        lod.firstIndex = firstIndex;
+        lod.indexCount = (UINT)level.mesh.indices.size();
+        lod.error = level.error;
+        hexagonLods.push_back(lod);
+
+        baseVertex += (UINT)level.mesh.vertices.size();
+        firstIndex += lod.indexCount;
+    }
+}
+
+void Engine::uploadVertexData() {
+    unsigned char* mapped = nullptr;
     D3D12_RANGE readRange{0, 0};
-    HRESULT hr = uploadBuffer->Map(0, &readRange, &mapped);
+    HRESULT hr = uploadBuffer->Map(0, &readRange, reinterpret_cast<void**>(&mapped));
     if (FAILED(hr)) throw std::runtime_error("failed to map vertex buffer");
 
-    std::memcpy(mapped, triangles, sizeof(triangles));
+    const UINT64 vertexBytes = vertexView.SizeInBytes;
+    for (size_t i = 0; i < hexagonLodChain.size(); i++) {
+        const Mesh& mesh = hexagonLodChain[i].mesh;
+        // Vertex is two tightly packed floats, so a mesh converts as one flat
+        // float array straight into the Half2 positions.
+        static_assert(sizeof(Vertex) == 2 * sizeof(float));
+        packHalf(
+            &mesh.vertices[0].x,
+            reinterpret_cast<uint16_t*>(mapped + hexagonLods[i].baseVertex * sizeof(PackedVertex)),
+            mesh.vertices.size() * 2
+        );
+        std::memcpy(mapped + vertexBytes + hexagonLods[i].firstIndex * sizeof(uint32_t), mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t));
+    }
     uploadBuffer->Unmap(0, nullptr);
 
-    commandList->CopyBufferRegion(vertexBuffer.Get(), 0, uploadBuffer.Get(), 0, sizeof(triangles));
+    // Only the GPU ranges are needed from here on.
+    hexagonLodChain.clear();
+
+    commandList->CopyBufferRegion(vertexBuffer.Get(), 0, uploadBuffer.Get(), 0, vertexBytes);
+    commandList->CopyBufferRegion(indexBuffer.Get(), 0, uploadBuffer.Get(), vertexBytes, indexView.SizeInBytes);
+    releaseQueue.retire(std::move(uploadBuffer));
 
-    std::cout << 100 << std::endl;
-    D3D12_RESOURCE_BARRIER barrier{};
-    barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-    barrier.Transition.pResource  = vertexBuffer.Get();
-    barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_COPY_DEST;
-    barrier.Transition.StateAfter  = D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER;
-    barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+    D3D12_RESOURCE_BARRIER barriers[2]{};
+    barriers[0].Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+    barriers[0].Transition.pResource  = vertexBuffer.Get();
+    barriers[0].Transition.StateBefore = D3D12_RESOURCE_STATE_COPY_DEST;
+    barriers[0].Transition.StateAfter  = D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER;
+    barriers[0].Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
 
-    commandList->ResourceBarrier(1, &barrier);
+    barriers[1] = barriers[0];
+    barriers[1].Transition.pResource  = indexBuffer.Get();
+    barriers[1].Transition.StateAfter  = D3D12_RESOURCE_STATE_INDEX_BUFFER;
+
+    commandList->ResourceBarrier(_countof(barriers), barriers);
 
     hr = commandList->Close();
     if (FAILED(hr)) {
@@ -301,24 +530,35 @@ void Engine::uploadVertexData() {
     ID3D12CommandList* lists[] = {commandList.Get()};
     commandQueue->ExecuteCommandLists(_countof(lists), lists);
 
-    waitForGPURenderFrame();
+    // Recorded into the first frame's allocator, which waits for this
+    // before reusing it; draws are ordered after the copies anyway.
+    signalSubmission();
 }
 
 void Engine::createRootSignature() {
-    D3D12_ROOT_CONSTANTS frameIdx{};
-    frameIdx.ShaderRegister = 0;
-    frameIdx.RegisterSpace = 0;
-    frameIdx.Num32BitValues = 1;
+    D3D12_ROOT_CONSTANTS view{};
+    view.ShaderRegister = 0;
+    view.RegisterSpace = 0;
+    view.Num32BitValues = sizeof(ViewConstants) / 4;
+
+    D3D12_ROOT_CONSTANTS object{};
+    object.ShaderRegister = 1;
+    object.RegisterSpace = 0;
+    object.Num32BitValues = sizeof(SceneObject) / 4;
 
-    D3D12_ROOT_PARAMETER parameter{};
-    parameter.ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
-    parameter.ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
-    parameter.Constants = frameIdx;
+    D3D12_ROOT_PARAMETER parameters[2]{};
+    parameters[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+    parameters[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+    parameters[0].Constants = view;
+
+    parameters[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+    parameters[1].ShaderVisibility = D3D12_SHADER_VISIBILITY_VERTEX;
+    parameters[1].Constants = object;
 
 
     D3D12_ROOT_SIGNATURE_DESC sigDesc{};
-    sigDesc.NumParameters = 1;
-    sigDesc.pParameters = &parameter;
+    sigDesc.NumParameters = _countof(parameters);
+    sigDesc.pParameters = parameters;
     sigDesc.NumStaticSamplers = 0;
     sigDesc.pStaticSamplers = nullptr;
     sigDesc.Flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
@@ -375,10 +615,7 @@ void Engine::createPipelineState() {
     pso.DepthStencilState.StencilEnable = FALSE;
 
 
-    D3D12_INPUT_ELEMENT_DESC inputLayout[]{
-        {"POSITION", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0}
-    };
-    pso.InputLayout = { inputLayout, _countof(inputLayout)};
+    pso.InputLayout = PipelineInputLayout<PackedVertex::Layout>::desc();
 
     HRESULT hr = device->CreateGraphicsPipelineState(
         &pso,
@@ -387,45 +624,130 @@ void Engine::createPipelineState() {
     if (FAILED(hr)) throw std::runtime_error("failed to crate graphics pipeline state");
 }
 
-void Engine::createVpAndSc() {
-    vp.TopLeftX = 0.0f;
-    vp.TopLeftY = 0.0f;
-    vp.Width    = (float)width;
-    vp.Height   = (float)height;
-    vp.MinDepth = 0.0f;
-    vp.MaxDepth = 1.0f;
+void Engine::createWorldPipelineState() {
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC pso{};
+    pso.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+
+    pso.SampleMask = UINT_MAX;
+    pso.NumRenderTargets = 1;
+    pso.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
+    pso.SampleDesc.Count = 1;
+
+    pso.pRootSignature = rootSignature.Get();
+
+    pso.VS.pShaderBytecode = g_hex_tile_vs;
+    pso.VS.BytecodeLength = sizeof(g_hex_tile_vs);
 
-    sc.left   = 0;
-    sc.top    = 0;
-    sc.right  = (LONG)width;
-    sc.bottom = (LONG)height;
+    pso.PS.pShaderBytecode = g_hex_tile_ps;
+    pso.PS.BytecodeLength = sizeof(g_hex_tile_ps);
+
+    pso.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
+    pso.BlendState      = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
+    pso.DepthStencilState.DepthEnable   = FALSE;
+    pso.DepthStencilState.StencilEnable = FALSE;
+
+    pso.InputLayout = PipelineInputLayout<PackedVertex::Layout, HexTileInstance::Layout>::desc();
+
+    HRESULT hr = device->CreateGraphicsPipelineState(
+        &pso,
+        IID_PPV_ARGS(worldPipelineState.GetAddressOf())
+    );
+    if (FAILED(hr)) throw std::runtime_error("failed to create world pipeline state");
 }
 
+void Engine::createOverlay() {
+    overlay = std::make_unique<Overlay>(device.Get(), commandList.Get(), releaseQueue);
+}
 
-void Engine::renderFrame() {
+bool Engine::renderFrame() {
     HRESULT hr;
 
-    frameBegin();
+    if (!isReady()) return false;
 
-    commandList->ResourceBarrier(1, &presentToRTVBarrier[bi]);
+    // Taken before streaming, the per-frame work most likely to allocate.
+    const uint64_t allocationsBefore = getAllocationCount();
 
-    commandList->OMSetRenderTargets(1, &rtvHandle[bi], FALSE, nullptr);
+    updateWorld();
 
-    commandList->ClearRenderTargetView(rtvHandle[bi], rendColor, 0, nullptr);
+    const bool continuous = continuousRequests > 0;
 
-    commandList->SetPipelineState(pipelineState.Get());
-    commandList->SetGraphicsRootSignature(rootSignature.Get());
-    commandList->SetGraphicsRoot32BitConstant(0, frameIdx, 0);
+    frameViews.clear();
+    UINT viewCount = 0;
+    for (auto& view : views) {
+        if (view == nullptr) continue;
 
-    commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-    commandList->IASetVertexBuffers(0, 1, &vertexView);
+        viewCount++;
+        if (view->needsRender(continuous)) {
+            frameViews.push_back(view.get());
+        }
+    }
 
-    commandList->RSSetViewports(1, &vp);
-    commandList->RSSetScissorRects(1, &sc);
+    if (frameViews.empty()) {
+        // Nothing new is submitted while idle, but what the last frames
+        // retired still goes once the GPU catches up.
+        releaseQueue.collect(fence->GetCompletedValue());
+        skippedFrames++;
+        return false;
+    }
 
-    commandList->DrawInstanced(18, 1, 0, 0);
+    // The HUD changes every frame, so its view is redrawn whenever any view is.
+    View* hudView = overlayEnabled ? primaryView() : nullptr;
+    if (hudView != nullptr && std::find(frameViews.begin(), frameViews.end(), hudView) == frameViews.end()) {
+        frameViews.push_back(hudView);
+    }
 
-    commandList->ResourceBarrier(1, rtvToPresentBarrier + bi);
+    auto now = std::chrono::steady_clock::now();
+    if (lastFrameTime != std::chrono::steady_clock::time_point{}) {
+        frameTimes[frameTimeCursor] = std::chrono::duration<float, std::milli>(now - lastFrameTime).count();
+        frameTimeCursor = (frameTimeCursor + 1) % frameTimeHistory;
+    }
+    lastFrameTime = now;
+
+    // The animation clock only runs while continuous rendering is held, so
+    // a still scene redrawn under the HUD or for damage matches what is
+    // already in the other back buffer.
+    if (continuous && lastAnimationTime != std::chrono::steady_clock::time_point{}) {
+        animationSeconds = std::fmod(
+            animationSeconds + std::chrono::duration<double>(now - lastAnimationTime).count(),
+            animationPeriodSeconds
+        );
+    }
+    lastAnimationTime = continuous ? now : std::chrono::steady_clock::time_point{};
+    animationAngle = (float)(2.0 * std::numbers::pi * animationSeconds / animationPeriodSeconds);
+
+    frameBegin();
+
+    auto start = std::chrono::steady_clock::now();
+
+    if (hudView != nullptr) {
+        buildOverlay(*hudView);
+    }
+
+    lodStats = {};
+    lodStats.objects = (UINT)objects.size();
+    occlusionStats = {};
+    recordStats = {};
+    worldStats.drawnChunks = 0;
+    worldStats.tilesSubmitted = 0;
+
+    for (View* view : frameViews) {
+        view->prepareFrame(continuous, sceneBounds);
+        recordView(*view);
+
+        if (view == hudView) {
+            auto overlayStart = std::chrono::steady_clock::now();
+            overlay->record(commandList.Get(), view->getWidth(), view->getHeight());
+            overlayStats.microseconds += std::chrono::duration<double, std::micro>(
+                std::chrono::steady_clock::now() - overlayStart
+            ).count();
+
+            if (overlayStats.microseconds > overlayBudgetMicroseconds) {
+                overlayStats.overBudgetFrames++;
+            }
+        }
+
+        view->recordEnd(commandList.Get());
+    }
 
     hr = commandList->Close();
     if (FAILED(hr)) {
@@ -435,82 +757,763 @@ void Engine::renderFrame() {
     ID3D12CommandList* lists[] = {commandList.Get()};
     commandQueue->ExecuteCommandLists(_countof(lists), lists);
 
-    hr = swapChain->Present(1, 0);
-    if (FAILED(hr)) {
-        throw std::runtime_error("failed to present buffer");
+    // Only the last present waits for vblank, otherwise every extra view
+    // would add a refresh interval to the frame. It is left out of the
+    // per-view timing for the same reason.
+    for (size_t i = 0; i + 1 < frameViews.size(); i++) {
+        frameViews[i]->present(0);
     }
 
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    frameViews.back()->present(1);
+
+    // Signalled after the presents so a view's fence also covers them.
+    const UINT64 submitted = signalSubmission();
+    for (View* view : frameViews) {
+        view->setLastUsedFence(submitted);
+    }
+
+    if (startupReport.firstFrameMilliseconds < 0.0) {
+        startupReport.firstFrameMilliseconds = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - startupBegin
+        ).count();
+    }
+
+    viewStats.viewCount = viewCount;
+    viewStats.renderedViews = (UINT)frameViews.size();
+    viewStats.microsecondsPerView =
+        std::chrono::duration<double, std::micro>(elapsed).count() / frameViews.size();
+
     frameEnd();
+
+    frameAllocations = getAllocationCount() - allocationsBefore;
+
+    return true;
 }
 
-void Engine::frameBegin() {
+void Engine::recordView(View& view) {
+    view.recordBegin(commandList.Get(), rendColor);
+
+    commandList->SetGraphicsRootSignature(rootSignature.Get());
+
+    // Bundles inherit the root constants bound here, so the camera and animation
+    // angle are patched per frame while the draws themselves are replayed.
+    ViewConstants constants = view.getConstants(animationAngle);
+    commandList->SetGraphicsRoot32BitConstants(0, sizeof(ViewConstants) / 4, &constants, 0);
+
+    recordWorld(view);
+
+    commandList->SetPipelineState(pipelineState.Get());
+
+    auto start = std::chrono::steady_clock::now();
+
+    if (!drawBundlesEnabled) {
+        recordDraws(commandList.Get(), view, view.getDamage(), lodStats, occlusionStats);
+        recordStats.recordedViews++;
+    } else {
+        DrawBundle& bundle = drawBundles[&view];
+        if (!isBundleCurrent(bundle, view)) {
+            recordBundle(bundle, view);
+            recordStats.recordedViews++;
+        } else {
+            recordStats.replayedViews++;
+        }
+
+        commandList->ExecuteBundle(bundle.buffers[bundle.current].commandList.Get());
+        addStats(lodStats, bundle.lodStats);
+        addStats(occlusionStats, bundle.occlusionStats);
+    }
+
+    recordStats.microseconds += std::chrono::duration<double, std::micro>(
+        std::chrono::steady_clock::now() - start
+    ).count();
+}
+
+void Engine::recordDraws(ID3D12GraphicsCommandList* list, View& view, const RECT& cullRect, LodStats& lodOut, OcclusionStats& occlusionOut) {
+    list->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    list->IASetVertexBuffers(0, 1, &vertexView);
+    list->IASetIndexBuffer(&indexView);
+
+    const FrameVector<uint8_t> objectVisible = cullObjects(view, cullRect, occlusionOut);
+
+    const float pixelsPerUnit = view.getPixelsPerUnit();
+    const UINT fullTriangles = hexagonLods[0].indexCount / 3;
+
+    for (size_t i = 0; i < objects.size(); i++) {
+        if (!objectVisible[i]) continue;
+
+        const SceneObject& object = objects[i];
+        const UINT level = selectLod(object.scale * pixelsPerUnit);
+        const MeshLod& lod = hexagonLods[level];
+
+        list->SetGraphicsRoot32BitConstants(1, sizeof(SceneObject) / 4, &object, 0);
+        list->DrawIndexedInstanced(lod.indexCount, 1, lod.firstIndex, lod.baseVertex, 0);
+
+        lodOut.drawnObjects++;
+        lodOut.objectsPerLevel[level]++;
+        lodOut.trianglesSubmitted += lod.indexCount / 3;
+        lodOut.trianglesSaved += fullTriangles - lod.indexCount / 3;
+    }
+}
+
+bool Engine::isBundleCurrent(const DrawBundle& bundle, View& view) {
+    if (bundle.buffers[bundle.current].commandList == nullptr || bundle.sceneVersion != sceneVersion) return false;
+
+    // Levels of detail and occluder sizes follow the on-screen scale.
+    if (bundle.pixelsPerUnit != view.getPixelsPerUnit()) return false;
+
+    const WorldRect visible = view.toWorld({0, 0, (LONG)view.getWidth(), (LONG)view.getHeight()});
+    return visible.minX >= bundle.cullBounds.minX && visible.maxX <= bundle.cullBounds.maxX &&
+        visible.minY >= bundle.cullBounds.minY && visible.maxY <= bundle.cullBounds.maxY;
+}
+
+void Engine::recordBundle(DrawBundle& bundle, View& view) {
     HRESULT hr;
 
-    bi = swapChain->GetCurrentBackBufferIndex();
+    // The list in use may still be executing, so the rebuild goes into the
+    // other one. The bundle only runs in this view, so the view's last frame
+    // is the last one that used it.
+    BundleBuffer& previous = bundle.buffers[bundle.current];
+    if (previous.commandList != nullptr) {
+        previous.lastUsedFence = view.getLastUsedFence();
+        bundle.current ^= 1;
+    }
 
-    waitForGPURenderFrame();
+    BundleBuffer& buffer = bundle.buffers[bundle.current];
+    if (buffer.commandList != nullptr && buffer.lastUsedFence > fence->GetCompletedValue()) {
+        // Rebuilt twice within the frames in flight: let the release queue
+        // drop the busy pair and start a fresh one instead of waiting.
+        releaseQueue.retire(std::move(buffer.commandList), buffer.lastUsedFence);
+        releaseQueue.retire(std::move(buffer.allocator), buffer.lastUsedFence);
+    }
 
-    hr = commandAllocator->Reset();
-    if (FAILED(hr)) {
-        throw std::runtime_error("failed to reset command allocator");
+    if (buffer.commandList == nullptr) {
+        hr = device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_BUNDLE, IID_PPV_ARGS(buffer.allocator.GetAddressOf()));
+        if (FAILED(hr)) {
+            throw std::runtime_error("failed to create bundle allocator");
+        }
+
+        hr = device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_BUNDLE, buffer.allocator.Get(), pipelineState.Get(), IID_PPV_ARGS(buffer.commandList.GetAddressOf()));
+        if (FAILED(hr)) {
+            throw std::runtime_error("failed to create bundle");
+        }
+    } else {
+        hr = buffer.allocator->Reset();
+        if (FAILED(hr)) {
+            throw std::runtime_error("failed to reset bundle allocator");
+        }
+
+        hr = buffer.commandList->Reset(buffer.allocator.Get(), pipelineState.Get());
+        if (FAILED(hr)) {
+            throw std::runtime_error("failed to reset bundle");
+        }
     }
 
-    hr = commandList->Reset(commandAllocator.Get(), nullptr);
+    // Culled against the view grown by a margin rather than this frame's
+    // damage, so the same draws stay valid for any damage region and for
+    // small pans; the scissor clips the rest.
+    const LONG marginX = (LONG)(view.getWidth() * bundleCullMargin);
+    const LONG marginY = (LONG)(view.getHeight() * bundleCullMargin);
+    const RECT cullRect{-marginX, -marginY, (LONG)view.getWidth() + marginX, (LONG)view.getHeight() + marginY};
+
+    bundle.lodStats = {};
+    bundle.occlusionStats = {};
+    buffer.commandList->SetGraphicsRootSignature(rootSignature.Get());
+    recordDraws(buffer.commandList.Get(), view, cullRect, bundle.lodStats, bundle.occlusionStats);
+
+    hr = buffer.commandList->Close();
     if (FAILED(hr)) {
-        throw std::runtime_error("failed to reset command allocator");
+        throw std::runtime_error("failed to close bundle");
     }
+
+    bundle.sceneVersion = sceneVersion;
+    bundle.pixelsPerUnit = view.getPixelsPerUnit();
+    bundle.cullBounds = view.toWorld(cullRect);
 }
 
-void Engine::frameEnd() {
-    frameIdx++;
+FrameVector<uint8_t> Engine::cullObjects(View& view, const RECT& cullRect, OcclusionStats& stats) {
+    auto start = std::chrono::steady_clock::now();
+
+    const float pixelsPerUnit = view.getPixelsPerUnit();
+
+    // The buffer covers the cull rectangle, which may reach past the view.
+    const LONG originX = cullRect.left;
+    const LONG originY = cullRect.top;
+    occlusionBuffer.begin(cullRect.right - cullRect.left, cullRect.bottom - cullRect.top);
+
+    if (occlusionCullingEnabled) {
+        FrameVector<std::pair<float, UINT>> occluderCandidates(frameArena());
+        for (UINT i = 0; i < objects.size(); i++) {
+            const float radius = hexagonRadius * occluderRadiusFactor * objects[i].scale * pixelsPerUnit;
+            if (radius >= minOccluderPixels) {
+                occluderCandidates.push_back({radius, i});
+            }
+        }
+
+        const size_t count = std::min<size_t>(occluderCandidates.size(), maxOccluders);
+        std::partial_sort(occluderCandidates.begin(), occluderCandidates.begin() + count, occluderCandidates.end(),
+            [](const auto& a, const auto& b) { return a.first > b.first; });
+
+        for (size_t i = 0; i < count; i++) {
+            const auto [radius, index] = occluderCandidates[i];
+            const SceneObject& object = objects[index];
+            RECT bounds = view.toPixels({object.x, object.y, object.x, object.y});
+            // toPixels rounds outwards, so the centre can be half a pixel off.
+            occlusionBuffer.addOccluder(
+                (bounds.left + bounds.right) / 2.f - originX,
+                (bounds.top + bounds.bottom) / 2.f - originY,
+                radius - 1.f,
+                index
+            );
+        }
+
+        occlusionBuffer.rasterize(*workerPool);
+    }
+
+    FrameVector<uint8_t> objectVisible(objects.size(), 0, frameArena());
+    std::atomic<UINT64> tested = 0, rejected = 0;
+
+    workerPool->parallelFor(objects.size(), 256, [&](size_t begin, size_t end) {
+        UINT64 localTested = 0, localRejected = 0;
+
+        for (size_t i = begin; i < end; i++) {
+            const SceneObject& object = objects[i];
+            const float radius = hexagonRadius * object.scale;
+            RECT bounds = view.toPixels({object.x - radius, object.y - radius, object.x + radius, object.y + radius});
+
+            // Only the part inside the cull rectangle gets drawn.
+            bounds.left = std::max(bounds.left, cullRect.left);
+            bounds.top = std::max(bounds.top, cullRect.top);
+            bounds.right = std::min(bounds.right, cullRect.right);
+            bounds.bottom = std::min(bounds.bottom, cullRect.bottom);
+            if (bounds.left >= bounds.right || bounds.top >= bounds.bottom) {
+                objectVisible[i] = false;
+                continue;
+            }
+
+            localTested++;
+            const RECT local{bounds.left - originX, bounds.top - originY, bounds.right - originX, bounds.bottom - originY};
+            const bool occluded = occlusionBuffer.isOccluded(local, (UINT)i);
+            localRejected += occluded;
+            objectVisible[i] = !occluded;
+        }
+
+        tested += localTested;
+        rejected += localRejected;
+    });
+
+    stats.occluders += occlusionBuffer.getOccluderCount();
+    stats.testedObjects += tested;
+    stats.rejectedObjects += rejected;
+    stats.milliseconds += std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start
+    ).count();
+
+    return objectVisible;
 }
 
-void Engine::waitForGPURenderFrame() {
-    const UINT64 signalValue = ++fenceValue;
-    HRESULT hr = commandQueue->Signal(fence.Get(), signalValue);
+void Engine::setWorldEnabled(bool enabled) {
+    if (enabled == worldEnabled) return;
+
+    worldEnabled = enabled;
+    if (!enabled) {
+        destroyWorld();
+    }
+    markDirty(DirtyWorld);
+}
+
+namespace {
+
+uint64_t chunkKey(ChunkCoord coord) {
+    return (uint64_t)(uint32_t)coord.x << 32 | (uint32_t)coord.y;
+}
+
+}
+
+void Engine::createWorld() {
+    world = std::make_unique<HexWorld>(worldLoaderThreads, 1u);
+
+    // The instance buffer outlives the world being switched off and on, as
+    // evicted slots may still be on their way back through the release queue.
+    if (worldInstanceBuffer != nullptr) return;
+
+    D3D12_HEAP_PROPERTIES uploadHeapProps{};
+    uploadHeapProps.Type = D3D12_HEAP_TYPE_UPLOAD;
+
+    D3D12_RESOURCE_DESC bufDesc{};
+    bufDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+    bufDesc.Width = worldSlotBytes * worldChunkSlots;
+    bufDesc.Height = 1;
+    bufDesc.DepthOrArraySize = 1;
+    bufDesc.MipLevels = 1;
+    bufDesc.SampleDesc.Count = 1;
+    bufDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+
+    // Tile instances are four bytes, so chunks are read straight from the
+    // upload heap instead of being copied again into a default heap.
+    HRESULT hr = device->CreateCommittedResource(
+        &uploadHeapProps,
+        D3D12_HEAP_FLAG_NONE,
+        &bufDesc,
+        D3D12_RESOURCE_STATE_GENERIC_READ,
+        nullptr,
+        IID_PPV_ARGS(worldInstanceBuffer.GetAddressOf())
+    );
     if (FAILED(hr)) {
-        throw std::runtime_error("failed to create command queue signal");
+        throw std::runtime_error("failed to create world instance buffer");
     }
 
-    if (fence->GetCompletedValue() < fenceValue) {
-        HRESULT hr = fence->SetEventOnCompletion(fenceValue, fenceEvent);
-        if (FAILED(hr)) {
-            throw std::runtime_error("failed to  set fence event on completion");
+    D3D12_RANGE readRange{0, 0};
+    hr = worldInstanceBuffer->Map(0, &readRange, reinterpret_cast<void**>(&mappedWorldInstances));
+    if (FAILED(hr)) {
+        throw std::runtime_error("failed to map world instance buffer");
+    }
+
+    freeWorldSlots.reserve(worldChunkSlots);
+    for (UINT slot = worldChunkSlots; slot > 0; slot--) {
+        freeWorldSlots.push_back(slot - 1);
+    }
+    retiredWorldSlots.reserve(worldChunkSlots);
+    worldChunks.reserve(worldChunkSlots);
+    wantedChunkKeys.reserve(maxWorldChunks);
+    missingChunks.reserve(maxWorldChunks);
+    loadedChunks.reserve(maxChunkUploadsPerFrame);
+}
+
+void Engine::destroyWorld() {
+    world.reset();
+    loadedChunks.clear();
+
+    for (const WorldChunk& chunk : worldChunks) {
+        retireWorldSlot(chunk.slot);
+    }
+    worldChunks.clear();
+
+    requestedWorldRanges.clear();
+    worldStats.residentChunks = 0;
+    worldStats.pendingChunks = 0;
+}
+
+size_t Engine::findWorldChunk(uint64_t key) {
+    auto it = std::lower_bound(worldChunks.begin(), worldChunks.end(), key, [](const WorldChunk& chunk, uint64_t wanted) {
+        return chunk.key < wanted;
+    });
+    return it - worldChunks.begin();
+}
+
+bool Engine::isChunkResident(uint64_t key) {
+    const size_t index = findWorldChunk(key);
+    return index < worldChunks.size() && worldChunks[index].key == key;
+}
+
+void Engine::retireWorldSlot(UINT slot) {
+    // The last submitted frame may still be reading the slot.
+    retiredWorldSlots.push_back({slot, submittedFenceValue});
+}
+
+void Engine::updateWorld() {
+    if (!worldEnabled) return;
+
+    if (world == nullptr) {
+        createWorld();
+    }
+
+    const UINT64 completedValue = fence->GetCompletedValue();
+    size_t returned = 0;
+    for (; returned < retiredWorldSlots.size() && retiredWorldSlots[returned].fenceValue <= completedValue; returned++) {
+        freeWorldSlots.push_back(retiredWorldSlots[returned].slot);
+    }
+    retiredWorldSlots.erase(retiredWorldSlots.begin(), retiredWorldSlots.begin() + returned);
+
+    const float chunkWidth = HexWorld::chunkWidth(worldTileScale);
+    const float chunkHeight = HexWorld::chunkHeight(worldTileScale);
+
+    // Everything a view can see plus a chunk of margin, capped so that a
+    // far zoomed-out view does not enumerate an unbounded area.
+    worldRanges.clear();
+    for (auto& view : views) {
+        if (view == nullptr || view->getHeight() == 0) continue;
+
+        const Camera& camera = view->getCamera();
+        const float halfHeight = 1.f / camera.zoom;
+        const float halfWidth = halfHeight * view->getWidth() / view->getHeight();
+
+        // Cameras moving within a chunk leave the ranges alone.
+        const int centreX = (int)std::floor(camera.x / chunkWidth);
+        const int centreY = (int)std::floor(camera.y / chunkHeight);
+        const int radiusX = std::min(maxWorldChunkRadius, (int)std::ceil(halfWidth / chunkWidth) + 1);
+        const int radiusY = std::min(maxWorldChunkRadius, (int)std::ceil(halfHeight / chunkHeight) + 1);
+
+        worldRanges.push_back({
+            centreX - radiusX,
+            centreY - radiusY,
+            centreX + radiusX,
+            centreY + radiusY,
+            centreX,
+            centreY
+        });
+    }
+
+    if (worldRanges != requestedWorldRanges) {
+        requestedWorldRanges = worldRanges;
+        requestWorldChunks();
+    }
+
+    bool changed = false;
+
+    if (loadedChunks.size() < maxChunkUploadsPerFrame) {
+        world->takeLoaded(loadedChunks, maxChunkUploadsPerFrame - loadedChunks.size());
+    }
+
+    size_t consumed = 0;
+    for (; consumed < loadedChunks.size(); consumed++) {
+        std::unique_ptr<HexChunk>& chunk = loadedChunks[consumed];
+        const uint64_t key = chunkKey(chunk->coord);
+
+        if (!std::binary_search(wantedChunkKeys.begin(), wantedChunkKeys.end(), key)) continue;
+
+        const size_t index = findWorldChunk(key);
+        if (index < worldChunks.size() && worldChunks[index].key == key) continue;
+        if (freeWorldSlots.empty()) break;
+
+        const UINT slot = freeWorldSlots.back();
+        freeWorldSlots.pop_back();
+        HexWorld::packInstances(*chunk, mappedWorldInstances + (size_t)slot * HexChunk::tileCount);
+
+        const ChunkCoord coord = chunk->coord;
+        worldChunks.insert(worldChunks.begin() + index, WorldChunk{key, coord, slot, HexWorld::chunkBounds(coord, worldTileScale), std::move(chunk)});
+        worldStats.chunksLoaded++;
+        changed = true;
+    }
+    loadedChunks.erase(loadedChunks.begin(), loadedChunks.begin() + consumed);
+
+    worldStats.residentChunks = (UINT)worldChunks.size();
+    worldStats.pendingChunks = (UINT)(world->getPendingCount() + loadedChunks.size());
+
+    if (changed) {
+        markDirty(DirtyWorld);
+    }
+}
+
+void Engine::requestWorldChunks() {
+    wantedChunks.clear();
+    for (const ChunkRange& range : worldRanges) {
+        for (int y = range.minY; y <= range.maxY; y++) {
+            for (int x = range.minX; x <= range.maxX; x++) {
+                wantedChunks.push_back({0.f, {x, y}});
+            }
+        }
+    }
+
+    // Overlapping views want the same chunks; keep one of each, at its
+    // distance from the nearest camera.
+    std::sort(wantedChunks.begin(), wantedChunks.end(), [](const WantedChunk& a, const WantedChunk& b) {
+        return chunkKey(a.coord) < chunkKey(b.coord);
+    });
+    wantedChunks.erase(std::unique(wantedChunks.begin(), wantedChunks.end(), [](const WantedChunk& a, const WantedChunk& b) {
+        return a.coord == b.coord;
+    }), wantedChunks.end());
+
+    for (WantedChunk& chunk : wantedChunks) {
+        chunk.distance = std::numeric_limits<float>::max();
+        for (const ChunkRange& range : worldRanges) {
+            const float dx = (float)(chunk.coord.x - range.centreX);
+            const float dy = (float)(chunk.coord.y - range.centreY);
+            chunk.distance = std::min(chunk.distance, dx * dx + dy * dy);
+        }
+    }
+
+    const size_t count = std::min<size_t>(wantedChunks.size(), maxWorldChunks);
+    std::partial_sort(wantedChunks.begin(), wantedChunks.begin() + count, wantedChunks.end(), [](const WantedChunk& a, const WantedChunk& b) {
+        return a.distance < b.distance;
+    });
+    wantedChunks.resize(count);
+
+    wantedChunkKeys.clear();
+    for (const WantedChunk& chunk : wantedChunks) {
+        wantedChunkKeys.push_back(chunkKey(chunk.coord));
+    }
+    std::sort(wantedChunkKeys.begin(), wantedChunkKeys.end());
+
+    auto unwanted = std::remove_if(worldChunks.begin(), worldChunks.end(), [this](const WorldChunk& chunk) {
+        if (std::binary_search(wantedChunkKeys.begin(), wantedChunkKeys.end(), chunk.key)) return false;
+
+        retireWorldSlot(chunk.slot);
+        return true;
+    });
+    const bool evicted = unwanted != worldChunks.end();
+    worldChunks.erase(unwanted, worldChunks.end());
+
+    // Chunks already built but still waiting for a slot are not missing.
+    missingChunks.clear();
+    for (const WantedChunk& chunk : wantedChunks) {
+        if (isChunkResident(chunkKey(chunk.coord))) continue;
+
+        const bool loaded = std::any_of(loadedChunks.begin(), loadedChunks.end(), [&](const std::unique_ptr<HexChunk>& built) {
+            return built->coord == chunk.coord;
+        });
+        if (!loaded) {
+            missingChunks.push_back(chunk.coord);
+        }
+    }
+    world->request(missingChunks);
+
+    if (evicted) {
+        markDirty(DirtyWorld);
+    }
+}
+
+void Engine::recordWorld(View& view) {
+    if (worldChunks.empty()) return;
+
+    commandList->SetPipelineState(worldPipelineState.Get());
+    commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    commandList->IASetIndexBuffer(&indexView);
+
+    // Every tile in the view is the same size on screen, so one level of
+    // detail serves the whole world.
+    const MeshLod& lod = hexagonLods[selectLod(worldTileScale * view.getPixelsPerUnit())];
+    const RECT& damage = view.getDamage();
+
+    // One binding covers every slot; each chunk starts at its own instance.
+    D3D12_VERTEX_BUFFER_VIEW buffers[2] = {vertexView, {}};
+    buffers[1].BufferLocation = worldInstanceBuffer->GetGPUVirtualAddress();
+    buffers[1].StrideInBytes = HexTileInstance::Layout::stride;
+    buffers[1].SizeInBytes = (UINT)(worldSlotBytes * worldChunkSlots);
+    commandList->IASetVertexBuffers(0, _countof(buffers), buffers);
+
+    for (const WorldChunk& chunk : worldChunks) {
+        RECT bounds = view.toPixels(chunk.bounds);
+        if (bounds.right <= damage.left || bounds.left >= damage.right ||
+            bounds.bottom <= damage.top || bounds.top >= damage.bottom) {
+            continue;
+        }
+
+        ChunkConstants constants{
+            chunk.coord.x * HexWorld::chunkWidth(worldTileScale),
+            chunk.coord.y * HexWorld::chunkHeight(worldTileScale),
+            worldTileScale
+        };
+        commandList->SetGraphicsRoot32BitConstants(1, sizeof(ChunkConstants) / 4, &constants, 0);
+        commandList->DrawIndexedInstanced(lod.indexCount, HexChunk::tileCount, lod.firstIndex, lod.baseVertex, chunk.slot * HexChunk::tileCount);
+
+        worldStats.drawnChunks++;
+        worldStats.tilesSubmitted += HexChunk::tileCount;
+        worldStats.totalTilesSubmitted += HexChunk::tileCount;
+    }
+}
+
+UINT Engine::selectLod(float pixelsPerUnit) {
+    // Coarsest level whose simplification error stays under the pixel
+    // tolerance once projected.
+    UINT level = 0;
+    for (UINT i = 1; i < hexagonLods.size(); i++) {
+        if (hexagonLods[i].error * pixelsPerUnit > maxLodPixelError) break;
+        level = i;
+    }
+    return level;
+}
+
+UINT Engine::addObject(const SceneObject& object) {
+    objects.push_back(object);
+
+    const float radius = hexagonRadius * object.scale;
+    WorldRect bounds{object.x - radius, object.y - radius, object.x + radius, object.y + radius};
+    if (objects.size() == 1) {
+        sceneBounds = bounds;
+    } else {
+        sceneBounds.minX = std::min(sceneBounds.minX, bounds.minX);
+        sceneBounds.minY = std::min(sceneBounds.minY, bounds.minY);
+        sceneBounds.maxX = std::max(sceneBounds.maxX, bounds.maxX);
+        sceneBounds.maxY = std::max(sceneBounds.maxY, bounds.maxY);
+    }
+
+    sceneVersion++;
+    markDirty(DirtyScene);
+    return (UINT)(objects.size() - 1);
+}
+
+void Engine::clearObjects() {
+    objects.clear();
+    sceneVersion++;
+    markDirty(DirtyWindow);
+    sceneBounds = {};
+}
+
+LodStats Engine::getLodStats() {
+    return lodStats;
+}
+
+OcclusionStats Engine::getOcclusionStats() {
+    return occlusionStats;
+}
 
+RecordStats Engine::getRecordStats() {
+    return recordStats;
+}
+
+WorldStats Engine::getWorldStats() {
+    return worldStats;
+}
+
+UINT64 Engine::getFrameAllocationCount() {
+    return frameAllocations;
+}
+
+View* Engine::primaryView() {
+    for (auto& view : views) {
+        if (view != nullptr) {
+            return view.get();
         }
+    }
+    return nullptr;
+}
+
+void Engine::buildOverlay(View& view) {
+    auto start = std::chrono::steady_clock::now();
+
+    const Unorm8x4 textColor = overlayColor(255, 255, 255);
+    const float lineHeight = 10.f;
+    const float left = 8.f;
+    float y = 8.f;
+
+    float lastFrameTime = frameTimes[(frameTimeCursor + frameTimeHistory - 1) % frameTimeHistory];
+    float maxFrameTime = 0.f;
+    for (float frameTime : frameTimes) {
+        maxFrameTime = std::max(maxFrameTime, frameTime);
+    }
+
+    char line[128];
+
+    overlay->begin(frameIdx);
 
-        WaitForSingleObject(fenceEvent, INFINITE);
+    std::snprintf(line, sizeof(line), "frame %llu  %.2f ms", frameIdx, lastFrameTime);
+    overlay->addText(left, y, line, textColor);
+    y += lineHeight;
+
+    std::snprintf(line, sizeof(line), "views %u/%u  %.1f us/view", viewStats.renderedViews, viewStats.viewCount, viewStats.microsecondsPerView);
+    overlay->addText(left, y, line, textColor);
+    y += lineHeight;
+
+    std::snprintf(line, sizeof(line), "skipped %llu", skippedFrames);
+    overlay->addText(left, y, line, textColor);
+    y += lineHeight;
+
+    std::snprintf(line, sizeof(line), "lod %u/%u objects  %llu tris  %llu saved", lodStats.drawnObjects, lodStats.objects, lodStats.trianglesSubmitted, lodStats.trianglesSaved);
+    overlay->addText(left, y, line, textColor);
+    y += lineHeight;
+
+    const double rejectedPercent = occlusionStats.testedObjects > 0
+        ? 100.0 * occlusionStats.rejectedObjects / occlusionStats.testedObjects : 0.0;
+    std::snprintf(line, sizeof(line), "occlusion %u occluders  %llu/%llu rejected (%.1f%%)  %.3f ms", occlusionStats.occluders, occlusionStats.rejectedObjects, occlusionStats.testedObjects, rejectedPercent, occlusionStats.milliseconds);
+    overlay->addText(left, y, line, textColor);
+    y += lineHeight;
+
+    if (worldEnabled) {
+        std::snprintf(line, sizeof(line), "world %u chunks drawn  %u resident  %u loading  %llu tiles", worldStats.drawnChunks, worldStats.residentChunks, worldStats.pendingChunks, worldStats.tilesSubmitted);
+        overlay->addText(left, y, line, textColor);
+        y += lineHeight;
+    }
+
+    std::snprintf(line, sizeof(line), "record %.1f us  %u replayed  %u recorded%s", recordStats.microseconds, recordStats.replayedViews, recordStats.recordedViews, drawBundlesEnabled ? "" : "  (bundles off)");
+    overlay->addText(left, y, line, textColor);
+    y += lineHeight;
+
+    if (isAllocationAuditEnabled()) {
+        std::snprintf(line, sizeof(line), "heap allocations %llu last frame", frameAllocations);
+        overlay->addText(left, y, line, textColor);
+        y += lineHeight;
+    }
+
+    std::snprintf(line, sizeof(line), "overlay %u quads  %.1f us  over budget %llu", overlayStats.quads, overlayStats.microseconds, overlayStats.overBudgetFrames);
+    overlay->addText(left, y, line, textColor);
+    y += lineHeight + 2.f;
+
+    // Graph history in order, oldest on the left.
+    float ordered[frameTimeHistory];
+    for (UINT i = 0; i < frameTimeHistory; i++) {
+        ordered[i] = frameTimes[(frameTimeCursor + i) % frameTimeHistory];
+    }
+    overlay->addGraph(left, y, 240.f, 40.f, ordered, frameTimeHistory, std::max(maxFrameTime, 16.7f), overlayColor(80, 220, 80));
+    y += 44.f;
+
+    // Stress filler: rows of printable ASCII up to the requested glyph count.
+    const UINT columns = std::max(1u, (view.getWidth() - 2 * (UINT)left) / Overlay::glyphAdvance);
+    UINT remaining = overlayStressGlyphs;
+    while (remaining > 0 && overlay->getQuadCount() < Overlay::maxQuads) {
+        UINT count = std::min(remaining, std::min(columns, (UINT)sizeof(line) - 1));
+        for (UINT i = 0; i < count; i++) {
+            line[i] = (char)('!' + (i + remaining) % ('~' - '!'));
+        }
+        overlay->addText(left, y, std::string_view(line, count), overlayColor(255, 255, 0, 160));
+        remaining -= count;
+        y += lineHeight;
     }
+
+    RECT bounds = overlay->getBounds();
+    view.addDamage(overlayBounds);
+    view.addDamage(bounds);
+    overlayBounds = bounds;
+
+    overlayStats.quads = overlay->getQuadCount();
+    overlayStats.microseconds = std::chrono::duration<double, std::micro>(
+        std::chrono::steady_clock::now() - start
+    ).count();
 }
 
-void Engine::generateHexagon(float x) {
-    float y = std::sqrt(3.f) * x / 2;
+void Engine::frameBegin() {
+    HRESULT hr;
+
+    // Only the frame that last recorded into this allocator has to be done;
+    // the one before this frame may still be running.
+    const UINT allocator = frameIdx % framesInFlight;
+    waitForFence(allocatorFenceValues[allocator]);
+
+    hr = commandAllocators[allocator]->Reset();
+    if (FAILED(hr)) {
+        throw std::runtime_error("failed to reset command allocator");
+    }
+
+    hr = commandList->Reset(commandAllocators[allocator].Get(), nullptr);
+    if (FAILED(hr)) {
+        throw std::runtime_error("failed to reset command allocator");
+    }
+}
 
-    triangles[0][0] = {0.f, 0.f};
-    triangles[0][1] = {x/2, y};
-    triangles[0][2] = {x, 0.f};
+void Engine::frameEnd() {
+    releaseQueue.collect(fence->GetCompletedValue());
+    resetFrameArenas();
+    frameIdx++;
+}
 
-    triangles[1][0] = {0.f, 0.f};
-    triangles[1][1] = {-x/2, y};
-    triangles[1][2] = {x/2, y};
+UINT64 Engine::signalSubmission() {
+    const UINT64 signalValue = ++fenceValue;
+    HRESULT hr = commandQueue->Signal(fence.Get(), signalValue);
+    if (FAILED(hr)) {
+        throw std::runtime_error("failed to create command queue signal");
+    }
 
-    triangles[2][0] = {0.f, 0.f};
-    triangles[2][1] = {-x, 0.f};
-    triangles[2][2] = {-x/2, y};
+    submittedFenceValue = signalValue;
+    allocatorFenceValues[frameIdx % framesInFlight] = signalValue;
+    releaseQueue.submit(signalValue);
+    return signalValue;
+}
 
-    triangles[3][0] = {0.f, 0.f};
-    triangles[3][1] = {-x/2, -y};
-    triangles[3][2] = {-x, 0.f};
+void Engine::waitForFence(UINT64 value) {
+    if (fence->GetCompletedValue() >= value) return;
 
-    triangles[4][0] = {0.f, 0.f};
-    triangles[4][1] = {x/2, -y};
-    triangles[4][2] = {-x/2, -y};
+    HRESULT hr = fence->SetEventOnCompletion(value, fenceEvent);
+    if (FAILED(hr)) {
+        throw std::runtime_error("failed to  set fence event on completion");
+    }
 
-    triangles[5][0] = {0.f, 0.f};
-    triangles[5][1] = {x, 0.f};
-    triangles[5][2] = {x/2, -y};
+    WaitForSingleObject(fenceEvent, INFINITE);
 }
 
 void Engine::stopRendering() {
-    // waitForGPURenderFrame();
+    if (!isReady()) return;
+
+    waitForFence(submittedFenceValue);
+    releaseQueue.collect(fence->GetCompletedValue());
 }
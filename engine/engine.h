@@ -2,95 +2,429 @@
 #define ENGINE_H_
 
 #include "types.h"
+#include "camera.h"
+#include "view.h"
+#include "overlay.h"
+#include "lod.h"
+#include "task_graph.h"
+#include "thread_pool.h"
+#include "occlusion.h"
+#include "release_queue.h"
+#include "frame_arena.h"
+#include "hex_world.h"
 
 #include <wrl.h>
 #include <dxgi1_6.h>
 #include <d3d12.h>
 #include <QImage>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 #pragma comment(lib, "dxgi.lib")
 #pragma comment(lib, "d3d12.lib")
 
 using Microsoft::WRL::ComPtr;
 
+using ViewId = UINT;
+
+struct ViewStats {
+    UINT viewCount = 0;
+    UINT renderedViews = 0;
+    // CPU time spent recording and presenting, averaged per rendered view.
+    double microsecondsPerView = 0.0;
+};
+
+struct OverlayStats {
+    UINT quads = 0;
+    // CPU time spent building and recording the overlay last frame.
+    double microseconds = 0.0;
+    UINT64 overBudgetFrames = 0;
+};
+
+// Per-object root constants. Must match ObjectConstants in ConstColorVS.hlsl.
+struct SceneObject {
+    float x, y;
+    float scale;
+};
+
+// Root constants for one world chunk, bound where SceneObject is.
+struct ChunkConstants {
+    float originX, originY;
+    float tileScale;
+};
+static_assert(sizeof(ChunkConstants) == sizeof(SceneObject), "ChunkConstants must fit the object root constants");
+
+struct MeshLod {
+    UINT baseVertex;
+    UINT firstIndex;
+    UINT indexCount;
+    float error;
+};
+
+struct LodStats {
+    static const UINT maxLevels = 8;
+
+    UINT objects = 0;
+    UINT drawnObjects = 0;
+    UINT objectsPerLevel[maxLevels]{};
+    // Summed over every view drawn last frame.
+    UINT64 trianglesSubmitted = 0;
+    UINT64 trianglesSaved = 0;
+};
+
+struct OcclusionStats {
+    UINT occluders = 0;
+    // Objects inside the damage region and how many of them were hidden,
+    // summed over every view drawn last frame.
+    UINT64 testedObjects = 0;
+    UINT64 rejectedObjects = 0;
+    // CPU time spent rasterizing occluders and testing objects.
+    double milliseconds = 0.0;
+};
+
+struct WorldStats {
+    UINT residentChunks = 0;
+    // Chunks queued or being built on the loader threads.
+    UINT pendingChunks = 0;
+    // Summed over every view drawn last frame.
+    UINT drawnChunks = 0;
+    UINT64 tilesSubmitted = 0;
+    // Running totals; the tile rate is the change over a known interval.
+    UINT64 totalTilesSubmitted = 0;
+    UINT64 chunksLoaded = 0;
+};
+
+struct RecordStats {
+    // Views whose draws were replayed from a bundle or recorded last frame.
+    UINT replayedViews = 0;
+    UINT recordedViews = 0;
+    // CPU time spent recording scene draws, including culling on re-record.
+    double microseconds = 0.0;
+};
+
+struct StartupReport {
+    // One entry per init task, relative to the start of startup.
+    std::vector<TaskGraph::Timing> phases;
+    // Since the Engine constructor; negative until reached.
+    double readyMilliseconds = -1.0;
+    double firstFrameMilliseconds = -1.0;
+};
+
 class Engine {
 public:
-    Engine();
-    Engine(HWND hwnd);
+    // The software (WARP) adapter is used to verify CPU-side costs
+    // independently of the GPU.
+    // Startup runs on worker threads and the constructor returns right away;
+    // views can be added once isReady() returns true.
+    explicit Engine(bool useWarpAdapter = false);
 
     ~Engine();
 
-    void renderFrame();
+    // Rethrows the startup error if initialization failed.
+    bool isReady();
+    StartupReport getStartupReport();
+
+    // Views share the device, queue, pipelines and geometry. Each one gets
+    // its own swap chain, camera and dirty state.
+    ViewId addView(HWND hwnd);
+    void removeView(ViewId id);
+    void resizeView(ViewId id, UINT width, UINT height);
+    void setCamera(ViewId id, const Camera& camera);
+    const Camera& getCamera(ViewId id);
+
+    // Records every view that needs drawing into one command list, submits
+    // it once and presents. Returns false when nothing changed since the
+    // last frame and the frame was skipped without touching the GPU.
+    bool renderFrame();
     void stopRendering();
 
+    void markDirty(UINT flags);
+    void markDirty(ViewId id, UINT flags);
+
+    // Animations hold a continuous render request for as long as they run.
+    void requestContinuousRendering();
+    void releaseContinuousRendering();
+
+    // Every object draws the hexagon mesh at the level of detail matching
+    // its size on screen.
+    UINT addObject(const SceneObject& object);
+    void clearObjects();
+
+    // Stats HUD drawn into the first view.
+    void setOverlayEnabled(bool enabled);
+    // Adds filler text to the HUD to measure the overlay with many glyphs.
+    void setOverlayStressGlyphs(UINT count);
+
+    // Skips objects hidden behind large objects drawn after them.
+    void setOcclusionCullingEnabled(bool enabled);
+    // Hex-tile world drawn under the objects, streamed in chunks around
+    // every view's camera on background threads.
+    void setWorldEnabled(bool enabled);
+
+    // Records each view's draws once into a bundle and replays it until the
+    // scene or zoom changes or the view pans past the area it was culled
+    // for. Off re-records every frame.
+    void setDrawBundlesEnabled(bool enabled);
+
+    // True while something finishes without a new frame being asked for:
+    // world chunks loading or GPU objects waiting to be released. Callers
+    // that stop calling renderFrame() when it returns false keep polling
+    // while this holds.
+    bool hasBackgroundWork();
+
     int getFrameIdx();
+    ViewStats getViewStats();
+    OverlayStats getOverlayStats();
+    LodStats getLodStats();
+    OcclusionStats getOcclusionStats();
+    RecordStats getRecordStats();
+    WorldStats getWorldStats();
+    // Heap allocations made during the last rendered frame, while the
+    // allocation audit is enabled. Steady-state frames should make none.
+    UINT64 getFrameAllocationCount();
+
+    static constexpr double overlayBudgetMicroseconds = 500.0;
 
 private:
     void prepareForRendering();
 
+    void createFactory();
     void createDevice();
 
     void createCommandsManagers();
 
-    void createSwapChain();
-    void createRenderTargetView();
-
-    void createBarriers();
     void createFence();
 
 
     void createVertexBuffer();
+    void buildHexagonLods();
     void uploadVertexData();
     void createRootSignature();
     void createPipelineState();
-    void createVpAndSc();
+    void createOverlay();
+    void createWorldPipelineState();
 
     void frameBegin();
     void frameEnd();
-    void waitForGPURenderFrame();
+    // Signals the fence after the work queued so far and stamps the
+    // release queue's pending entries with the new value.
+    UINT64 signalSubmission();
+    // Waits only if the GPU has not reached fenceValue yet.
+    void waitForFence(UINT64 value);
 
-    void generateHexagon(float x);
+    struct DrawBundle;
 
-private:
-    static const int bufferCount = 2;
-    int bi{};
+    // Visibility per object, allocated from the frame arena.
+    FrameVector<uint8_t> cullObjects(View& view, const RECT& cullRect, OcclusionStats& stats);
+    void recordView(View& view);
+    void recordDraws(ID3D12GraphicsCommandList* list, View& view, const RECT& cullRect, LodStats& lodOut, OcclusionStats& occlusionOut);
+    bool isBundleCurrent(const DrawBundle& bundle, View& view);
+    void recordBundle(DrawBundle& bundle, View& view);
 
-    UINT width = 600, height = 600;
+    void createWorld();
+    void destroyWorld();
+    void updateWorld();
+    void requestWorldChunks();
+    // Index of the chunk in worldChunks, or where it would be inserted.
+    size_t findWorldChunk(uint64_t key);
+    bool isChunkResident(uint64_t key);
+    void retireWorldSlot(UINT slot);
+    void recordWorld(View& view);
 
+    UINT selectLod(float pixelsPerUnit);
+    View* primaryView();
+    View* findView(ViewId id);
+    void buildOverlay(View& view);
+
+private:
     ComPtr<IDXGIFactory4> dxgiFactory{};
     ComPtr<ID3D12Device> device{};
 
     ComPtr<ID3D12CommandQueue> commandQueue{};
-    ComPtr<ID3D12CommandAllocator> commandAllocator;
+    // Frames the CPU may record ahead of the GPU. The overlay keeps as many
+    // copies of its quads.
+    static const UINT framesInFlight = 2;
+    ComPtr<ID3D12CommandAllocator> commandAllocators[framesInFlight];
     ComPtr<ID3D12GraphicsCommandList1> commandList;
 
-    DXGI_SWAP_CHAIN_DESC1 swapChainDesc{};
-    ComPtr<IDXGISwapChain3> swapChain{};
-
-    ComPtr<ID3D12Resource> backBuffers[bufferCount];
-    ComPtr<ID3D12DescriptorHeap> rtvHeap{};
-    D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle[bufferCount];
-
-    D3D12_RESOURCE_BARRIER rtvToPresentBarrier[bufferCount];
-    D3D12_RESOURCE_BARRIER presentToRTVBarrier[bufferCount];
-
     ComPtr<ID3D12Fence> fence;
-    HANDLE fenceEvent;
+    HANDLE fenceEvent = nullptr;
     UINT64 fenceValue = 0;
+    UINT64 submittedFenceValue = 0;
+    // Last value signalled for each allocator; it is reused once that
+    // value completes.
+    UINT64 allocatorFenceValues[framesInFlight]{};
+
+    ReleaseQueue releaseQueue;
 
     ComPtr<ID3D12Resource> uploadBuffer{};
     ComPtr<ID3D12Resource> vertexBuffer{};
+    ComPtr<ID3D12Resource> indexBuffer{};
     D3D12_VERTEX_BUFFER_VIEW vertexView{};
+    D3D12_INDEX_BUFFER_VIEW indexView{};
     ComPtr<ID3D12RootSignature> rootSignature{};
     ComPtr<ID3D12PipelineState> pipelineState{};
-    D3D12_VIEWPORT vp{};
-    D3D12_RECT sc{};
 
-    Vertex triangles[6][3];
-    Vertex triangleVerticies[3] = {{0.0, 0.5}, {0.5, -0.5}, {-0.5, -0.5}};
+    // Indexed by ViewId; removed views leave an empty slot so ids stay stable.
+    std::vector<std::unique_ptr<View>> views;
+    std::vector<View*> frameViews;
+
+    static constexpr float hexagonRadius = 0.5f;
+    static const unsigned hexagonDetail = 6;
+    // Thresholds in hexagon units; levels that remove nothing are dropped.
+    inline static const std::vector<float> lodErrorThresholds = {0.0005f, 0.002f, 0.01f, 0.05f};
+    static constexpr float maxLodPixelError = 0.5f;
+
+    std::vector<LodLevel> hexagonLodChain;
+    std::vector<MeshLod> hexagonLods;
+
+    std::vector<SceneObject> objects;
+    WorldRect sceneBounds{};
+    LodStats lodStats{};
+
+    // Occluders are the largest objects on screen, shrunk to a disc inside
+    // the coarsest LOD outline so rotation never uncovers anything.
+    static constexpr float occluderRadiusFactor = 0.8f;
+    static constexpr float minOccluderPixels = 24.f;
+    static const UINT maxOccluders = 64;
+
+    std::unique_ptr<ThreadPool> workerPool;
+    OcclusionBuffer occlusionBuffer;
+    bool occlusionCullingEnabled = true;
+    OcclusionStats occlusionStats{};
+
+    // Scene draws of one view, valid while everything they were culled and
+    // LOD-selected against is unchanged.
+    // The camera only reaches a bundle through the view root constants, so
+    // what it records depends on the scene, the level of detail and what
+    // was culled. Bundles cull a margin around the view so panning can
+    // replay them for a while.
+    struct BundleBuffer {
+        ComPtr<ID3D12CommandAllocator> allocator;
+        ComPtr<ID3D12GraphicsCommandList> commandList;
+        // Last submission that executed this list.
+        UINT64 lastUsedFence = 0;
+    };
+
+    // A rebuild records into the list the previous frames did not use, so
+    // it never waits for the GPU.
+    struct DrawBundle {
+        BundleBuffer buffers[2];
+        UINT current = 0;
+        UINT64 sceneVersion = 0;
+        float pixelsPerUnit = 0.f;
+        WorldRect cullBounds{};
+        LodStats lodStats{};
+        OcclusionStats occlusionStats{};
+    };
+
+    // Fraction of the view size culled for on each side of a bundle.
+    static constexpr float bundleCullMargin = 0.25f;
+
+    // Bumped by anything that changes which draws a view records.
+    UINT64 sceneVersion = 0;
+    bool drawBundlesEnabled = true;
+    std::unordered_map<View*, DrawBundle> drawBundles;
+    RecordStats recordStats{};
+
+    UINT64 frameAllocations = 0;
+
+    static constexpr float worldTileScale = 1.f;
+    // A million tiles resident at most, nearest to the cameras first.
+    static const UINT maxWorldChunks = 1024;
+    // Evicted slots come back a frame or two later, once the GPU is done.
+    static const UINT worldChunkSlots = maxWorldChunks + 64;
+    static const int maxWorldChunkRadius = 64;
+    static const UINT maxChunkUploadsPerFrame = 32;
+    static const unsigned worldLoaderThreads = 2;
+    static const UINT64 worldSlotBytes = sizeof(HexTileInstance) * HexChunk::tileCount;
+
+    // The tiles stay resident on the CPU; the instance buffer slot holds
+    // them packed for drawing.
+    struct WorldChunk {
+        uint64_t key;
+        ChunkCoord coord;
+        UINT slot;
+        WorldRect bounds;
+        std::unique_ptr<HexChunk> tiles;
+    };
+
+    struct RetiredWorldSlot {
+        UINT slot;
+        UINT64 fenceValue;
+    };
+
+    struct WantedChunk {
+        float distance;
+        ChunkCoord coord;
+    };
+
+    // Chunks around one view and the chunk its camera is in.
+    struct ChunkRange {
+        int minX, minY, maxX, maxY;
+        int centreX, centreY;
+
+        bool operator==(const ChunkRange&) const = default;
+    };
+
+    bool worldEnabled = false;
+    std::unique_ptr<HexWorld> world;
+    ComPtr<ID3D12PipelineState> worldPipelineState{};
+    ComPtr<ID3D12Resource> worldInstanceBuffer{};
+    HexTileInstance* mappedWorldInstances = nullptr;
+    // Streaming runs on the render thread, so everything it keeps is
+    // reserved up front for the full slot count and never grows in a frame.
+    std::vector<UINT> freeWorldSlots;
+    // Evicted slots in fence order, back to freeWorldSlots once the GPU is done.
+    std::vector<RetiredWorldSlot> retiredWorldSlots;
+    // Sorted by key.
+    std::vector<WorldChunk> worldChunks;
+    std::vector<ChunkRange> worldRanges;
+    std::vector<ChunkRange> requestedWorldRanges;
+    std::vector<WantedChunk> wantedChunks;
+    // Sorted, for lookups while evicting and integrating.
+    std::vector<uint64_t> wantedChunkKeys;
+    std::vector<ChunkCoord> missingChunks;
+    // Built chunks waiting for an upload slot.
+    std::vector<std::unique_ptr<HexChunk>> loadedChunks;
+    WorldStats worldStats{};
+
     float rendColor[4] = {0.f, 0.5f, 0.f, 1.f};
     UINT64 frameIdx = 0;
 
-    HWND hwnd;
+    // Hexagon rotation, one turn per period of continuous rendering.
+    static constexpr double animationPeriodSeconds = 2.0;
+    double animationSeconds = 0.0;
+    float animationAngle = 0.f;
+    std::chrono::steady_clock::time_point lastAnimationTime{};
+
+    int continuousRequests = 0;
+    UINT64 skippedFrames = 0;
+
+    ViewStats viewStats{};
+
+    std::unique_ptr<Overlay> overlay;
+    bool overlayEnabled = false;
+    UINT overlayStressGlyphs = 0;
+    RECT overlayBounds{};
+    OverlayStats overlayStats{};
+
+    static const UINT frameTimeHistory = 120;
+    float frameTimes[frameTimeHistory]{};
+    UINT frameTimeCursor = 0;
+    std::chrono::steady_clock::time_point lastFrameTime{};
+
+    bool useWarpAdapter = false;
+
+    std::thread startupThread;
+    std::atomic<bool> startupFinished = false;
+    std::exception_ptr startupError;
+    std::chrono::steady_clock::time_point startupBegin{};
+    StartupReport startupReport{};
 };
 
 #endif
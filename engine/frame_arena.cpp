@@ -0,0 +1,73 @@
+#include "frame_arena.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
+FrameArena::FrameArena(size_t capacity) : block(new std::byte[capacity]), capacity(capacity) {
+}
+
+void* FrameArena::allocate(size_t bytes, size_t alignment) {
+    const uintptr_t base = reinterpret_cast<uintptr_t>(block.get());
+    const uintptr_t aligned = (base + offset + alignment - 1) & ~(uintptr_t)(alignment - 1);
+
+    if (aligned + bytes <= base + capacity) {
+        offset = aligned + bytes - base;
+        peak = std::max(peak, offset + overflowBytes);
+        return reinterpret_cast<void*>(aligned);
+    }
+
+    const size_t size = bytes + alignment;
+    overflow.emplace_back(new std::byte[size]);
+    overflowBytes += size;
+    peak = std::max(peak, offset + overflowBytes);
+
+    const uintptr_t spill = reinterpret_cast<uintptr_t>(overflow.back().get());
+    return reinterpret_cast<void*>((spill + alignment - 1) & ~(uintptr_t)(alignment - 1));
+}
+
+void FrameArena::reset() {
+    if (!overflow.empty()) {
+        overflow.clear();
+        overflowBytes = 0;
+
+        capacity = std::max(capacity * 2, peak);
+        block.reset(new std::byte[capacity]);
+    }
+    offset = 0;
+}
+
+namespace {
+
+std::atomic<uint64_t> arenaFrame = 0;
+
+struct ThreadArena {
+    FrameArena arena;
+    uint64_t frame = arenaFrame.load(std::memory_order_relaxed);
+};
+
+ThreadArena& threadArena() {
+    thread_local ThreadArena threadArena;
+    return threadArena;
+}
+
+}
+
+FrameArena& frameArena() {
+    return threadArena().arena;
+}
+
+void resetFrameArenas() {
+    ThreadArena& current = threadArena();
+    current.arena.reset();
+    current.frame = arenaFrame.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+void syncFrameArena() {
+    ThreadArena& current = threadArena();
+    const uint64_t frame = arenaFrame.load(std::memory_order_relaxed);
+    if (current.frame != frame) {
+        current.arena.reset();
+        current.frame = frame;
+    }
+}
@@ -0,0 +1,77 @@
+#ifndef FRAME_ARENA_H_
+#define FRAME_ARENA_H_
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Linear allocator for data that only lives until the end of the frame.
+// Allocation bumps an offset and freeing is a no-op; reset() drops
+// everything at once. A frame that outgrows the block spills into extra
+// heap blocks, and the next reset() grows the block to fit, so only the
+// first frames at a new peak ever touch the heap.
+class FrameArena {
+public:
+    static const size_t defaultCapacity = 256 * 1024;
+
+    explicit FrameArena(size_t capacity = defaultCapacity);
+
+    void* allocate(size_t bytes, size_t alignment);
+    void reset();
+
+private:
+    std::unique_ptr<std::byte[]> block;
+    size_t capacity;
+    size_t offset = 0;
+
+    std::vector<std::unique_ptr<std::byte[]>> overflow;
+    size_t overflowBytes = 0;
+    // Most bytes used by a single frame so far.
+    size_t peak = 0;
+};
+
+// The calling thread's arena, created on first use.
+FrameArena& frameArena();
+// Ends the frame for every arena. Each arena is only ever reset by its own
+// thread: the caller's right away, any other thread's at its next
+// syncFrameArena().
+void resetFrameArenas();
+// Resets the calling thread's arena if a frame has ended since it was last
+// reset. Threads other than the render thread call this where they hold
+// nothing from their arena, such as before taking a job.
+void syncFrameArena();
+
+// Standard allocator over a FrameArena, for containers that are built and
+// thrown away within one frame.
+template <class T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    ArenaAllocator(FrameArena& arena) noexcept : arena(&arena) {}
+
+    template <class U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena(other.arena) {}
+
+    T* allocate(size_t count) {
+        return static_cast<T*>(arena->allocate(count * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T*, size_t) noexcept {}
+
+    template <class U>
+    bool operator==(const ArenaAllocator<U>& other) const noexcept {
+        return arena == other.arena;
+    }
+
+private:
+    template <class U>
+    friend class ArenaAllocator;
+
+    FrameArena* arena;
+};
+
+template <class T>
+using FrameVector = std::vector<T, ArenaAllocator<T>>;
+
+#endif
@@ -0,0 +1,179 @@
+#include "hex_world.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const float sqrt3 = 1.7320508f;
+
+uint32_t hash(int x, int y, uint32_t seed) {
+    uint32_t h = seed ^ (uint32_t)x * 0x8DA6B343u ^ (uint32_t)y * 0xD8163841u;
+    h ^= h >> 15;
+    h *= 0x2C1B3C6Du;
+    h ^= h >> 12;
+    h *= 0x297A2D39u;
+    h ^= h >> 15;
+    return h;
+}
+
+// Smoothly interpolated lattice noise in [0, 1].
+float valueNoise(float x, float y, uint32_t seed) {
+    const float fx = std::floor(x), fy = std::floor(y);
+    const int ix = (int)fx, iy = (int)fy;
+    float tx = x - fx, ty = y - fy;
+    tx = tx * tx * (3.f - 2.f * tx);
+    ty = ty * ty * (3.f - 2.f * ty);
+
+    auto corner = [&](int dx, int dy) {
+        return (hash(ix + dx, iy + dy, seed) & 0xFFFF) / 65535.f;
+    };
+    const float top = corner(0, 0) + (corner(1, 0) - corner(0, 0)) * tx;
+    const float bottom = corner(0, 1) + (corner(1, 1) - corner(0, 1)) * tx;
+    return top + (bottom - top) * ty;
+}
+
+float terrainHeight(float x, float y, uint32_t seed) {
+    float value = 0.f, amplitude = 0.5f, frequency = 1.f / 48.f;
+    for (int octave = 0; octave < 4; octave++) {
+        value += amplitude * valueNoise(x * frequency, y * frequency, seed + octave);
+        amplitude *= 0.5f;
+        frequency *= 2.f;
+    }
+    return std::clamp(value / 0.9375f, 0.f, 1.f);
+}
+
+}
+
+HexWorld::HexWorld(unsigned loaderThreads, uint32_t seed) : seed(seed) {
+    building.reserve(std::max(loaderThreads, 1u));
+    for (unsigned i = 0; i < std::max(loaderThreads, 1u); i++) {
+        loaders.emplace_back(&HexWorld::loaderLoop, this);
+    }
+}
+
+HexWorld::~HexWorld() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+
+    for (std::thread& loader : loaders) {
+        loader.join();
+    }
+}
+
+void HexWorld::request(const std::vector<ChunkCoord>& chunks) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.clear();
+        for (auto it = chunks.rbegin(); it != chunks.rend(); ++it) {
+            const ChunkCoord& coord = *it;
+            const bool inProgress =
+                std::find(building.begin(), building.end(), coord) != building.end() ||
+                std::any_of(finished.begin(), finished.end(), [&](const auto& chunk) { return chunk->coord == coord; });
+            if (!inProgress) {
+                queue.push_back(coord);
+            }
+        }
+    }
+    wake.notify_all();
+}
+
+void HexWorld::takeLoaded(std::vector<std::unique_ptr<HexChunk>>& loaded, size_t maxChunks) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    const size_t count = std::min(maxChunks, finished.size());
+    for (size_t i = 0; i < count; i++) {
+        loaded.push_back(std::move(finished[i]));
+    }
+    finished.erase(finished.begin(), finished.begin() + count);
+}
+
+size_t HexWorld::getPendingCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return queue.size() + building.size();
+}
+
+float HexWorld::chunkWidth(float tileScale) {
+    return HexChunk::size * 1.5f * 0.5f * tileScale;
+}
+
+float HexWorld::chunkHeight(float tileScale) {
+    return HexChunk::size * sqrt3 * 0.5f * tileScale;
+}
+
+WorldRect HexWorld::chunkBounds(ChunkCoord coord, float tileScale) {
+    // Tiles overhang the chunk origin by a radius on the left and half a
+    // tile height at the bottom, and odd columns reach another half tile up.
+    const float radius = 0.5f * tileScale;
+    const float minX = coord.x * chunkWidth(tileScale);
+    const float minY = coord.y * chunkHeight(tileScale);
+    return {
+        minX - radius,
+        minY - radius,
+        minX + chunkWidth(tileScale) + radius,
+        minY + chunkHeight(tileScale) + radius
+    };
+}
+
+void HexWorld::loaderLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true) {
+        wake.wait(lock, [this] { return stopping || !queue.empty(); });
+        if (stopping) return;
+
+        const ChunkCoord coord = queue.back();
+        queue.pop_back();
+        building.push_back(coord);
+        lock.unlock();
+
+        auto chunk = std::make_unique<HexChunk>();
+        chunk->coord = coord;
+        build(*chunk);
+
+        lock.lock();
+        building.erase(std::find(building.begin(), building.end(), coord));
+        finished.push_back(std::move(chunk));
+    }
+}
+
+void HexWorld::build(HexChunk& chunk) {
+    const int firstColumn = chunk.coord.x * (int)HexChunk::size;
+    const int firstRow = chunk.coord.y * (int)HexChunk::size;
+
+    for (UINT row = 0; row < HexChunk::size; row++) {
+        for (UINT column = 0; column < HexChunk::size; column++) {
+            const UINT i = row * HexChunk::size + column;
+            const int q = firstColumn + (int)column;
+            const int r = firstRow + (int)row;
+
+            // Sample in tile space so the noise scale does not depend on the
+            // tile size; odd columns sit half a row up.
+            const float h = terrainHeight(q * 0.866f, r + 0.5f * (q & 1), seed);
+            chunk.height[i] = (uint8_t)(h * 255.f);
+
+            uint8_t terrain;
+            if (h < 0.40f) terrain = TerrainWater;
+            else if (h < 0.45f) terrain = TerrainSand;
+            else if (h < 0.60f) terrain = TerrainGrass;
+            else if (h < 0.70f) terrain = TerrainForest;
+            else if (h < 0.80f) terrain = TerrainRock;
+            else terrain = TerrainSnow;
+            chunk.terrain[i] = terrain;
+        }
+    }
+}
+
+void HexWorld::packInstances(const HexChunk& chunk, HexTileInstance* instances) {
+    for (UINT i = 0; i < HexChunk::tileCount; i++) {
+        instances[i].tile = {
+            (uint8_t)(i % HexChunk::size),
+            (uint8_t)(i / HexChunk::size),
+            chunk.terrain[i],
+            chunk.height[i]
+        };
+    }
+}
@@ -0,0 +1,92 @@
+#ifndef HEX_WORLD_H_
+#define HEX_WORLD_H_
+
+#include "types.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Per-instance data of one hex tile. Must match the TILE input in
+// HexTileVS.hlsl.
+struct HexTileInstance {
+    Uint8x4 tile;       // column, row within the chunk, terrain, height
+
+    using Layout = InstanceLayout<1, Attribute<"TILE", Uint8x4>>;
+};
+static_assert(HexTileInstance::Layout::matches<HexTileInstance>(), "HexTileInstance does not match its input layout");
+
+enum HexTerrain : uint8_t {
+    TerrainWater,
+    TerrainSand,
+    TerrainGrass,
+    TerrainForest,
+    TerrainRock,
+    TerrainSnow,
+};
+
+struct ChunkCoord {
+    int x, y;
+
+    bool operator==(const ChunkCoord&) const = default;
+};
+
+// A square block of flat-topped hex tiles in odd-q offset layout, one
+// array per attribute. This is the resident copy of the tiles; the GPU gets
+// them packed by HexWorld::packInstances().
+struct HexChunk {
+    static const UINT size = 32;
+    static const UINT tileCount = size * size;
+
+    ChunkCoord coord;
+    uint8_t terrain[tileCount];
+    uint8_t height[tileCount];
+};
+
+// Procedural hex-tile world generated chunk by chunk on background threads.
+// The caller decides which chunks it wants and collects them once built.
+class HexWorld {
+public:
+    HexWorld(unsigned loaderThreads, uint32_t seed);
+    ~HexWorld();
+
+    // Replaces the load queue; chunks are built in the given order. Chunks
+    // already being built or waiting to be taken are finished regardless
+    // and not queued again. Called from the render thread, so it reuses the
+    // queue's storage rather than allocating.
+    void request(const std::vector<ChunkCoord>& chunks);
+    // Moves up to maxChunks finished chunks into loaded.
+    void takeLoaded(std::vector<std::unique_ptr<HexChunk>>& loaded, size_t maxChunks);
+    // Queued or being built.
+    size_t getPendingCount();
+
+    // Layout helpers; tileScale is the scale the hexagon mesh is drawn at.
+    static WorldRect chunkBounds(ChunkCoord coord, float tileScale);
+    static float chunkWidth(float tileScale);
+    static float chunkHeight(float tileScale);
+    // Writes tileCount instances in order; instances may be write-combined
+    // memory, so it is never read back.
+    static void packInstances(const HexChunk& chunk, HexTileInstance* instances);
+
+private:
+    void loaderLoop();
+    void build(HexChunk& chunk);
+
+private:
+    uint32_t seed;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    // In reverse order, so loaders take the next chunk from the back.
+    std::vector<ChunkCoord> queue;
+    std::vector<std::unique_ptr<HexChunk>> finished;
+    std::vector<ChunkCoord> building;
+    bool stopping = false;
+
+    std::vector<std::thread> loaders;
+};
+
+#endif
@@ -0,0 +1,297 @@
+#include "lod.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <map>
+#include <queue>
+
+namespace {
+
+struct Vec3 {
+    double x, y, z;
+
+    Vec3 operator+(const Vec3& o) const { return {x + o.x, y + o.y, z + o.z}; }
+    Vec3 operator-(const Vec3& o) const { return {x - o.x, y - o.y, z - o.z}; }
+    Vec3 operator*(double s) const { return {x * s, y * s, z * s}; }
+};
+
+double dot(const Vec3& a, const Vec3& b) {
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+Vec3 cross(const Vec3& a, const Vec3& b) {
+    return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+}
+
+Vec3 normalize(const Vec3& v) {
+    double len = std::sqrt(dot(v, v));
+    return len > 0.0 ? v * (1.0 / len) : Vec3{0.0, 0.0, 0.0};
+}
+
+// Symmetric 4x4 matrix of the plane equation outer product, upper triangle.
+struct Quadric {
+    double a[10]{};
+
+    static Quadric fromPlane(const Vec3& n, double d) {
+        Quadric q;
+        q.a[0] = n.x * n.x; q.a[1] = n.x * n.y; q.a[2] = n.x * n.z; q.a[3] = n.x * d;
+        q.a[4] = n.y * n.y; q.a[5] = n.y * n.z; q.a[6] = n.y * d;
+        q.a[7] = n.z * n.z; q.a[8] = n.z * d;
+        q.a[9] = d * d;
+        return q;
+    }
+
+    Quadric& operator+=(const Quadric& o) {
+        for (int i = 0; i < 10; i++) a[i] += o.a[i];
+        return *this;
+    }
+
+    double evaluate(const Vec3& p) const {
+        return a[0] * p.x * p.x + 2 * a[1] * p.x * p.y + 2 * a[2] * p.x * p.z + 2 * a[3] * p.x
+             + a[4] * p.y * p.y + 2 * a[5] * p.y * p.z + 2 * a[6] * p.y
+             + a[7] * p.z * p.z + 2 * a[8] * p.z
+             + a[9];
+    }
+};
+
+struct Collapse {
+    double cost;
+    uint32_t from, to;
+    uint32_t fromVersion, toVersion;
+    Vec3 position;
+
+    bool operator>(const Collapse& o) const { return cost > o.cost; }
+};
+
+class Simplifier {
+public:
+    explicit Simplifier(const Mesh& mesh);
+
+    void simplify(double maxError);
+    Mesh extract();
+    // Largest error of any collapse made so far, in mesh units.
+    double getError() const;
+
+private:
+    void pushEdge(uint32_t a, uint32_t b);
+    bool collapseFlipsTriangles(uint32_t v, uint32_t other, const Vec3& position);
+    void collapse(const Collapse& c);
+
+private:
+    std::vector<Vec3> positions;
+    std::vector<Quadric> quadrics;
+    std::vector<uint32_t> versions;
+    std::vector<bool> removed;
+    std::vector<std::array<uint32_t, 3>> triangles;
+    std::vector<bool> dead;
+    std::vector<std::vector<uint32_t>> vertexTriangles;
+
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> heap;
+    double maxCollapseCost = 0.0;
+};
+
+Simplifier::Simplifier(const Mesh& mesh) {
+    const size_t vertexCount = mesh.vertices.size();
+
+    positions.reserve(vertexCount);
+    for (const Vertex& v : mesh.vertices) {
+        positions.push_back({v.x, v.y, 0.0});
+    }
+    quadrics.resize(vertexCount);
+    versions.resize(vertexCount);
+    removed.resize(vertexCount);
+    vertexTriangles.resize(vertexCount);
+
+    std::map<std::pair<uint32_t, uint32_t>, int> edgeUse;
+
+    for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+        std::array<uint32_t, 3> tri{mesh.indices[i], mesh.indices[i + 1], mesh.indices[i + 2]};
+        uint32_t t = (uint32_t)triangles.size();
+        triangles.push_back(tri);
+        dead.push_back(false);
+
+        const Vec3& p0 = positions[tri[0]];
+        Vec3 n = normalize(cross(positions[tri[1]] - p0, positions[tri[2]] - p0));
+        Quadric q = Quadric::fromPlane(n, -dot(n, p0));
+
+        for (int k = 0; k < 3; k++) {
+            quadrics[tri[k]] += q;
+            vertexTriangles[tri[k]].push_back(t);
+
+            uint32_t a = tri[k], b = tri[(k + 1) % 3];
+            edgeUse[{std::min(a, b), std::max(a, b)}]++;
+        }
+    }
+
+    // Border edges get a plane through the edge, perpendicular to the face,
+    // so moving a border vertex off the outline is penalised.
+    for (const auto& tri : triangles) {
+        const Vec3& p0 = positions[tri[0]];
+        Vec3 faceNormal = normalize(cross(positions[tri[1]] - p0, positions[tri[2]] - p0));
+
+        for (int k = 0; k < 3; k++) {
+            uint32_t a = tri[k], b = tri[(k + 1) % 3];
+            if (edgeUse[{std::min(a, b), std::max(a, b)}] != 1) continue;
+
+            Vec3 n = normalize(cross(positions[b] - positions[a], faceNormal));
+            Quadric q = Quadric::fromPlane(n, -dot(n, positions[a]));
+            quadrics[a] += q;
+            quadrics[b] += q;
+        }
+    }
+
+    for (const auto& edge : edgeUse) {
+        pushEdge(edge.first.first, edge.first.second);
+    }
+}
+
+void Simplifier::pushEdge(uint32_t a, uint32_t b) {
+    Quadric q = quadrics[a];
+    q += quadrics[b];
+
+    // Only the endpoints and the midpoint are tried; the optimal position
+    // is singular for flat meshes, which is all this engine draws.
+    const Vec3 candidates[3] = {positions[a], positions[b], (positions[a] + positions[b]) * 0.5};
+
+    Collapse best{};
+    best.cost = -1.0;
+    for (int i = 0; i < 3; i++) {
+        double cost = std::max(q.evaluate(candidates[i]), 0.0);
+        if (best.cost < 0.0 || cost < best.cost) {
+            // Collapsing onto a keeps a; everything else keeps b.
+            best = {cost, i == 0 ? b : a, i == 0 ? a : b, 0, 0, candidates[i]};
+        }
+    }
+    best.fromVersion = versions[best.from];
+    best.toVersion = versions[best.to];
+    heap.push(best);
+}
+
+bool Simplifier::collapseFlipsTriangles(uint32_t v, uint32_t other, const Vec3& position) {
+    for (uint32_t t : vertexTriangles[v]) {
+        if (dead[t]) continue;
+
+        const auto& tri = triangles[t];
+        if (tri[0] == other || tri[1] == other || tri[2] == other) continue;
+
+        Vec3 p[3];
+        Vec3 q[3];
+        for (int k = 0; k < 3; k++) {
+            p[k] = positions[tri[k]];
+            q[k] = tri[k] == v ? position : p[k];
+        }
+
+        Vec3 before = cross(p[1] - p[0], p[2] - p[0]);
+        Vec3 after = cross(q[1] - q[0], q[2] - q[0]);
+        if (dot(before, after) <= 1e-12 * dot(before, before)) return true;
+    }
+    return false;
+}
+
+void Simplifier::collapse(const Collapse& c) {
+    const uint32_t from = c.from, to = c.to;
+
+    for (uint32_t t : vertexTriangles[from]) {
+        if (dead[t]) continue;
+
+        auto& tri = triangles[t];
+        if (tri[0] == to || tri[1] == to || tri[2] == to) {
+            dead[t] = true;
+            continue;
+        }
+
+        for (auto& index : tri) {
+            if (index == from) index = to;
+        }
+        vertexTriangles[to].push_back(t);
+    }
+    vertexTriangles[from].clear();
+
+    removed[from] = true;
+    versions[from]++;
+    versions[to]++;
+    positions[to] = c.position;
+    quadrics[to] += quadrics[from];
+
+    // Drop dead triangles from the survivor's list and re-queue its edges.
+    auto& adjacent = vertexTriangles[to];
+    adjacent.erase(std::remove_if(adjacent.begin(), adjacent.end(), [&](uint32_t t) { return dead[t]; }), adjacent.end());
+
+    std::vector<uint32_t> neighbours;
+    for (uint32_t t : adjacent) {
+        for (uint32_t index : triangles[t]) {
+            if (index != to) neighbours.push_back(index);
+        }
+    }
+    std::sort(neighbours.begin(), neighbours.end());
+    neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+
+    for (uint32_t n : neighbours) {
+        pushEdge(to, n);
+    }
+}
+
+void Simplifier::simplify(double maxError) {
+    const double maxCost = maxError * maxError;
+
+    while (!heap.empty()) {
+        Collapse c = heap.top();
+        if (c.cost > maxCost) break;
+        heap.pop();
+
+        if (removed[c.from] || removed[c.to]) continue;
+        if (c.fromVersion != versions[c.from] || c.toVersion != versions[c.to]) continue;
+
+        if (collapseFlipsTriangles(c.from, c.to, c.position) ||
+            collapseFlipsTriangles(c.to, c.from, c.position)) {
+            continue;
+        }
+
+        collapse(c);
+        maxCollapseCost = std::max(maxCollapseCost, c.cost);
+    }
+}
+
+double Simplifier::getError() const {
+    return std::sqrt(maxCollapseCost);
+}
+
+Mesh Simplifier::extract() {
+    Mesh mesh;
+    std::vector<uint32_t> remap(positions.size(), UINT32_MAX);
+
+    for (size_t t = 0; t < triangles.size(); t++) {
+        if (dead[t]) continue;
+
+        for (uint32_t index : triangles[t]) {
+            if (remap[index] == UINT32_MAX) {
+                remap[index] = (uint32_t)mesh.vertices.size();
+                mesh.vertices.push_back({(float)positions[index].x, (float)positions[index].y});
+            }
+            mesh.indices.push_back(remap[index]);
+        }
+    }
+
+    return mesh;
+}
+
+}
+
+std::vector<LodLevel> buildLodChain(const Mesh& mesh, const std::vector<float>& errorThresholds) {
+    std::vector<LodLevel> chain;
+    chain.push_back({mesh, 0.f});
+
+    Simplifier simplifier(mesh);
+    for (float threshold : errorThresholds) {
+        simplifier.simplify(threshold);
+
+        Mesh level = simplifier.extract();
+        // Thresholds that remove nothing more add no level.
+        if (level.triangleCount() >= chain.back().mesh.triangleCount()) continue;
+
+        chain.push_back({std::move(level), (float)simplifier.getError()});
+    }
+
+    return chain;
+}
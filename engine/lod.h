@@ -0,0 +1,23 @@
+#ifndef LOD_H_
+#define LOD_H_
+
+#include "mesh.h"
+
+#include <vector>
+
+struct LodLevel {
+    Mesh mesh;
+    // Largest error of the collapses that built this level, in mesh units
+    // (distance, not squared). The quadric sums squared distances to every
+    // merged plane, so this bounds how far the outline moved.
+    float error;
+};
+
+// Simplifies `mesh` with quadric error metric edge collapses (Garland and
+// Heckbert). Level 0 is the input mesh; every following level continues
+// collapsing from the previous one until the next collapse would exceed the
+// matching threshold. Thresholds must be increasing. Open borders are kept
+// in place by constraint planes perpendicular to boundary edges.
+std::vector<LodLevel> buildLodChain(const Mesh& mesh, const std::vector<float>& errorThresholds);
+
+#endif
@@ -0,0 +1,43 @@
+#include "mesh.h"
+
+#include <cmath>
+#include <numbers>
+
+Mesh generateHexagon(float radius, unsigned detail) {
+    const unsigned segments = detail > 0 ? detail : 1;
+    const float pi = std::numbers::pi_v<float>;
+
+    // Each corner is replaced by an arc tangent to both sides. A 120 degree
+    // corner puts the arc centre rounding / sin(60) in from the corner.
+    const float rounding = 0.15f * radius;
+    const float arcCentreDist = radius - rounding / std::sin(pi / 3.f);
+
+    std::vector<Vertex> rim;
+    for (unsigned corner = 0; corner < 6; corner++) {
+        const float cornerAngle = corner * pi / 3.f;
+        const float cx = arcCentreDist * std::cos(cornerAngle);
+        const float cy = arcCentreDist * std::sin(cornerAngle);
+
+        for (unsigned i = 0; i <= segments; i++) {
+            float a = cornerAngle - pi / 6.f + (pi / 3.f) * i / segments;
+            rim.push_back({cx + rounding * std::cos(a), cy + rounding * std::sin(a)});
+        }
+        // The straight side to the next arc needs no points of its own.
+    }
+
+    const uint32_t rimSize = (uint32_t)rim.size();
+
+    // The interior is flat, so all the detail goes into the outline and the
+    // inside is a single fan from the centre.
+    Mesh mesh;
+    mesh.vertices.push_back({0.f, 0.f});
+    mesh.vertices.insert(mesh.vertices.end(), rim.begin(), rim.end());
+
+    // Rim points run counter-clockwise, so (centre, next, current) is
+    // clockwise.
+    for (uint32_t i = 0; i < rimSize; i++) {
+        mesh.indices.insert(mesh.indices.end(), {0, 1 + (i + 1) % rimSize, 1 + i});
+    }
+
+    return mesh;
+}
@@ -0,0 +1,23 @@
+#ifndef MESH_H_
+#define MESH_H_
+
+#include "types.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Indexed triangle list with clockwise winding.
+struct Mesh {
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+
+    size_t triangleCount() const { return indices.size() / 3; }
+};
+
+// Hexagon with rounded corners, centred at the origin with its corners at
+// `radius`, drawn as a fan from the centre. `detail` sets the number of arc
+// segments per corner, so the triangle count grows linearly with it.
+Mesh generateHexagon(float radius, unsigned detail);
+
+#endif
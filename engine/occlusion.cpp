@@ -0,0 +1,174 @@
+#include "occlusion.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define OCCLUSION_SSE2 1
+#endif
+
+void OcclusionBuffer::begin(UINT width, UINT height) {
+    occluders.clear();
+
+    this->width = width;
+    this->height = height;
+    tilesX = (width + tileSize - 1) / tileSize;
+    tilesY = (height + tileSize - 1) / tileSize;
+    tileStride = (tilesX + 3) / 4 * 4 + 4;
+    blocksX = (tilesX + blockTiles - 1) / blockTiles;
+    blocksY = (tilesY + blockTiles - 1) / blockTiles;
+
+    tiles.resize((size_t)tileStride * tilesY);
+    blocks.resize((size_t)blocksX * blocksY);
+}
+
+void OcclusionBuffer::addOccluder(float x, float y, float radius, UINT order) {
+    if (radius <= 0.f) return;
+    occluders.push_back({x, y, radius, (int32_t)order + 1});
+}
+
+UINT OcclusionBuffer::getOccluderCount() const {
+    return (UINT)occluders.size();
+}
+
+void OcclusionBuffer::rasterize(ThreadPool& pool) {
+    pool.parallelFor(tilesY, 4, [this](size_t begin, size_t end) {
+        for (size_t y = begin; y < end; y++) {
+            rasterizeRow((UINT)y);
+        }
+    });
+
+    pool.parallelFor(blocksY, 1, [this](size_t begin, size_t end) {
+        for (size_t y = begin; y < end; y++) {
+            buildBlockRow((UINT)y);
+        }
+    });
+}
+
+void OcclusionBuffer::rasterizeRow(UINT tileY) {
+    int32_t* row = &tiles[(size_t)tileY * tileStride];
+    std::fill(row, row + tileStride, 0);
+
+    const float top = (float)(tileY * tileSize);
+    const float bottom = top + tileSize;
+
+    for (const Occluder& occluder : occluders) {
+        if (top < occluder.y - occluder.radius || bottom > occluder.y + occluder.radius) continue;
+
+        // A disc covers a tile when it holds all four corners, so the row's
+        // farthest edge decides how wide the covered span is.
+        const float dy = std::max(std::abs(top - occluder.y), std::abs(bottom - occluder.y));
+        const float halfWidth2 = occluder.radius * occluder.radius - dy * dy;
+        if (halfWidth2 <= 0.f) continue;
+
+        const float halfWidth = std::sqrt(halfWidth2);
+        const float minX = occluder.x - halfWidth;
+        const float maxX = occluder.x + halfWidth;
+
+        const int first = std::max(0, (int)std::ceil(minX / tileSize));
+        const int last = std::min((int)tilesX, (int)std::floor(maxX / tileSize)) - 1;
+        if (first > last) continue;
+
+#ifdef OCCLUSION_SSE2
+        // Four tiles per step from an aligned start; the corner test masks
+        // off the lanes outside the span.
+        const __m128 lanes = _mm_setr_ps(0.f, 1.f, 2.f, 3.f);
+        const __m128 size = _mm_set1_ps((float)tileSize);
+        const __m128 minXs = _mm_set1_ps(minX);
+        const __m128 maxXs = _mm_set1_ps(maxX);
+        const __m128i depth = _mm_set1_epi32(occluder.depth);
+
+        for (int x = first & ~3; x <= last; x += 4) {
+            const __m128 left = _mm_mul_ps(_mm_add_ps(_mm_set1_ps((float)x), lanes), size);
+            const __m128 right = _mm_add_ps(left, size);
+            const __m128i covered = _mm_castps_si128(_mm_and_ps(_mm_cmpge_ps(left, minXs), _mm_cmple_ps(right, maxXs)));
+
+            __m128i* dst = reinterpret_cast<__m128i*>(row + x);
+            const __m128i current = _mm_loadu_si128(dst);
+            const __m128i replace = _mm_and_si128(covered, _mm_cmpgt_epi32(depth, current));
+            _mm_storeu_si128(dst, _mm_or_si128(_mm_and_si128(replace, depth), _mm_andnot_si128(replace, current)));
+        }
+#else
+        for (int x = first; x <= last; x++) {
+            row[x] = std::max(row[x], occluder.depth);
+        }
+#endif
+    }
+}
+
+void OcclusionBuffer::buildBlockRow(UINT blockY) {
+    const UINT y0 = blockY * blockTiles;
+    const UINT y1 = std::min(y0 + blockTiles, tilesY);
+
+    for (UINT blockX = 0; blockX < blocksX; blockX++) {
+        const UINT x0 = blockX * blockTiles;
+        const UINT x1 = std::min(x0 + blockTiles, tilesX);
+
+        int32_t depth = INT32_MAX;
+        for (UINT y = y0; y < y1; y++) {
+            const int32_t* row = &tiles[(size_t)y * tileStride];
+            depth = std::min(depth, *std::min_element(row + x0, row + x1));
+        }
+        blocks[(size_t)blockY * blocksX + blockX] = depth;
+    }
+}
+
+bool OcclusionBuffer::rowVisible(UINT tileY, UINT x0, UINT x1, int32_t depth) const {
+    const int32_t* row = &tiles[(size_t)tileY * tileStride];
+
+#ifdef OCCLUSION_SSE2
+    const __m128i limit = _mm_set1_epi32(depth + 1);
+    for (UINT x = x0; x <= x1; x += 4) {
+        const __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+        int open = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(values, limit)));
+        if (x1 - x < 3) {
+            open &= (1 << (x1 - x + 1)) - 1;
+        }
+        if (open != 0) return true;
+    }
+    return false;
+#else
+    for (UINT x = x0; x <= x1; x++) {
+        if (row[x] <= depth) return true;
+    }
+    return false;
+#endif
+}
+
+bool OcclusionBuffer::isOccluded(const RECT& bounds, UINT order) const {
+    if (occluders.empty()) return false;
+
+    const LONG left = std::max<LONG>(bounds.left, 0);
+    const LONG top = std::max<LONG>(bounds.top, 0);
+    const LONG right = std::min<LONG>(bounds.right, (LONG)width);
+    const LONG bottom = std::min<LONG>(bounds.bottom, (LONG)height);
+    if (left >= right || top >= bottom) return false;
+
+    const UINT tileX0 = (UINT)left / tileSize;
+    const UINT tileX1 = (UINT)(right - 1) / tileSize;
+    const UINT tileY0 = (UINT)top / tileSize;
+    const UINT tileY1 = (UINT)(bottom - 1) / tileSize;
+
+    // Only occluders drawn later hide the object; tiles covered by the
+    // object itself (order + 1) count as visible.
+    const int32_t depth = (int32_t)order + 1;
+
+    for (UINT blockY = tileY0 / blockTiles; blockY <= tileY1 / blockTiles; blockY++) {
+        for (UINT blockX = tileX0 / blockTiles; blockX <= tileX1 / blockTiles; blockX++) {
+            if (blocks[(size_t)blockY * blocksX + blockX] > depth) continue;
+
+            const UINT x0 = std::max(tileX0, blockX * blockTiles);
+            const UINT x1 = std::min(tileX1, blockX * blockTiles + blockTiles - 1);
+            const UINT y0 = std::max(tileY0, blockY * blockTiles);
+            const UINT y1 = std::min(tileY1, blockY * blockTiles + blockTiles - 1);
+
+            for (UINT y = y0; y <= y1; y++) {
+                if (rowVisible(y, x0, x1, depth)) return false;
+            }
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,60 @@
+#ifndef OCCLUSION_H_
+#define OCCLUSION_H_
+
+#include "thread_pool.h"
+
+#include <windows.h>
+#include <cstdint>
+#include <vector>
+
+// Coarse software occlusion buffer for one view. The scene is drawn in
+// order without depth testing, so an object is hidden when occluders drawn
+// after it cover its whole footprint: each tile stores the draw order of
+// the latest occluder covering it completely, and plays the role of depth.
+// Blocks of tiles keep the minimum of their tiles so most tests finish at
+// the coarse level.
+class OcclusionBuffer {
+public:
+    static const UINT tileSize = 8;
+    static const UINT blockTiles = 8;
+
+    // Clears the occluder list and sizes the buffer for a view in pixels.
+    void begin(UINT width, UINT height);
+    // Disc in pixels, completely opaque once drawn; order is its draw index.
+    void addOccluder(float x, float y, float radius, UINT order);
+    // Tile rows are split across the pool.
+    void rasterize(ThreadPool& pool);
+
+    // True when occluders drawn after order cover all of bounds. Safe to
+    // call from several threads once rasterize() has returned.
+    bool isOccluded(const RECT& bounds, UINT order) const;
+
+    UINT getOccluderCount() const;
+
+private:
+    struct Occluder {
+        float x, y;
+        float radius;
+        int32_t depth;
+    };
+
+    void rasterizeRow(UINT tileY);
+    void buildBlockRow(UINT blockY);
+    // True when any tile in [x0, x1] of row tileY is not covered beyond depth.
+    bool rowVisible(UINT tileY, UINT x0, UINT x1, int32_t depth) const;
+
+private:
+    std::vector<Occluder> occluders;
+
+    UINT width = 0, height = 0;
+    UINT tilesX = 0, tilesY = 0;
+    // Rows are padded so four tiles can always be loaded at once.
+    UINT tileStride = 0;
+    UINT blocksX = 0, blocksY = 0;
+
+    // order + 1 of the covering occluder, 0 where nothing covers the tile.
+    std::vector<int32_t> tiles;
+    std::vector<int32_t> blocks;
+};
+
+#endif
@@ -0,0 +1,393 @@
+#include "overlay.h"
+#include "overlay_font.h"
+#include "overlay_vs.h"
+#include "overlay_ps.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include "d3dx12.h"
+
+Overlay::Overlay(ID3D12Device* device, ID3D12GraphicsCommandList1* commandList, ReleaseQueue& releaseQueue) : device(device) {
+    createAtlas(commandList, releaseQueue);
+    createInstanceBuffers();
+    createRootSignature();
+    createPipelineState();
+}
+
+void Overlay::createAtlas(ID3D12GraphicsCommandList1* commandList, ReleaseQueue& releaseQueue) {
+    HRESULT hr;
+    ComPtr<ID3D12Resource> atlasUpload;
+
+    D3D12_HEAP_PROPERTIES defaultHeapProps{};
+    defaultHeapProps.Type = D3D12_HEAP_TYPE_DEFAULT;
+
+    D3D12_HEAP_PROPERTIES uploadHeapProps{};
+    uploadHeapProps.Type = D3D12_HEAP_TYPE_UPLOAD;
+
+    D3D12_RESOURCE_DESC texDesc{};
+    texDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+    texDesc.Width = atlasWidth;
+    texDesc.Height = atlasHeight;
+    texDesc.DepthOrArraySize = 1;
+    texDesc.MipLevels = 1;
+    texDesc.Format = DXGI_FORMAT_R8_UNORM;
+    texDesc.SampleDesc.Count = 1;
+    texDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+
+    hr = device->CreateCommittedResource(
+        &defaultHeapProps,
+        D3D12_HEAP_FLAG_NONE,
+        &texDesc,
+        D3D12_RESOURCE_STATE_COPY_DEST,
+        nullptr,
+        IID_PPV_ARGS(atlas.GetAddressOf())
+    );
+    if (FAILED(hr)) {
+        throw std::runtime_error("failed to create glyph atlas");
+    }
+
+    const UINT rowPitch =
+        (atlasWidth + D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1) & ~(D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1);
+
+    D3D12_RESOURCE_DESC bufDesc{};
+    bufDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+    bufDesc.Width = rowPitch * atlasHeight;
+    bufDesc.Height = 1;
+    bufDesc.DepthOrArraySize = 1;
+    bufDesc.MipLevels = 1;
+    bufDesc.SampleDesc.Count = 1;
+    bufDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+
+    hr = device->CreateCommittedResource(
+        &uploadHeapProps,
+        D3D12_HEAP_FLAG_NONE,
+        &bufDesc,
+        D3D12_RESOURCE_STATE_GENERIC_READ,
+        nullptr,
+        IID_PPV_ARGS(atlasUpload.GetAddressOf())
+    );
+    if (FAILED(hr)) {
+        throw std::runtime_error("failed to create glyph atlas upload buffer");
+    }
+
+    // Expand the 1bpp font into an 8bpp coverage atlas, 16 glyphs per row.
+    unsigned char* mapped = nullptr;
+    D3D12_RANGE readRange{0, 0};
+    hr = atlasUpload->Map(0, &readRange, reinterpret_cast<void**>(&mapped));
+    if (FAILED(hr)) throw std::runtime_error("failed to map glyph atlas upload buffer");
+
+    std::memset(mapped, 0, bufDesc.Width);
+    for (int glyph = 0; glyph < overlayFontCharCount; glyph++) {
+        const UINT cellX = (glyph % atlasColumns) * overlayFontCellSize;
+        const UINT cellY = (glyph / atlasColumns) * overlayFontCellSize;
+
+        for (int row = 0; row < overlayFontCellSize; row++) {
+            unsigned char bits = overlayFont[glyph][row];
+            unsigned char* dst = mapped + (cellY + row) * rowPitch + cellX;
+            for (int col = 0; col < overlayFontCellSize; col++) {
+                dst[col] = (bits >> col) & 1 ? 0xFF : 0x00;
+            }
+        }
+    }
+    atlasUpload->Unmap(0, nullptr);
+
+    D3D12_TEXTURE_COPY_LOCATION dst{};
+    dst.pResource = atlas.Get();
+    dst.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+    dst.SubresourceIndex = 0;
+
+    D3D12_TEXTURE_COPY_LOCATION src{};
+    src.pResource = atlasUpload.Get();
+    src.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+    src.PlacedFootprint.Offset = 0;
+    src.PlacedFootprint.Footprint.Format = DXGI_FORMAT_R8_UNORM;
+    src.PlacedFootprint.Footprint.Width = atlasWidth;
+    src.PlacedFootprint.Footprint.Height = atlasHeight;
+    src.PlacedFootprint.Footprint.Depth = 1;
+    src.PlacedFootprint.Footprint.RowPitch = rowPitch;
+
+    commandList->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
+    releaseQueue.retire(std::move(atlasUpload));
+
+    D3D12_RESOURCE_BARRIER barrier{};
+    barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+    barrier.Transition.pResource  = atlas.Get();
+    barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_COPY_DEST;
+    barrier.Transition.StateAfter  = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+    barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+
+    commandList->ResourceBarrier(1, &barrier);
+
+    D3D12_DESCRIPTOR_HEAP_DESC heapDesc{};
+    heapDesc.NumDescriptors = 1;
+    heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+    heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+
+    hr = device->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(srvHeap.GetAddressOf()));
+    if (FAILED(hr)) {
+        throw std::runtime_error("failed to create overlay descriptor heap");
+    }
+
+    D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc{};
+    srvDesc.Format = DXGI_FORMAT_R8_UNORM;
+    srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+    srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+    srvDesc.Texture2D.MipLevels = 1;
+
+    device->CreateShaderResourceView(atlas.Get(), &srvDesc, srvHeap->GetCPUDescriptorHandleForHeapStart());
+}
+
+void Overlay::createInstanceBuffers() {
+    D3D12_HEAP_PROPERTIES uploadHeapProps{};
+    uploadHeapProps.Type = D3D12_HEAP_TYPE_UPLOAD;
+
+    D3D12_RESOURCE_DESC bufDesc{};
+    bufDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+    bufDesc.Width = sizeof(OverlayQuad) * maxQuads;
+    bufDesc.Height = 1;
+    bufDesc.DepthOrArraySize = 1;
+    bufDesc.MipLevels = 1;
+    bufDesc.SampleDesc.Count = 1;
+    bufDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+
+    for (int i = 0; i < frameCount; i++) {
+        HRESULT hr = device->CreateCommittedResource(
+            &uploadHeapProps,
+            D3D12_HEAP_FLAG_NONE,
+            &bufDesc,
+            D3D12_RESOURCE_STATE_GENERIC_READ,
+            nullptr,
+            IID_PPV_ARGS(instanceBuffers[i].GetAddressOf())
+        );
+        if (FAILED(hr)) {
+            throw std::runtime_error("failed to create overlay instance buffer");
+        }
+
+        // Upload heaps may stay mapped for their whole lifetime.
+        D3D12_RANGE readRange{0, 0};
+        hr = instanceBuffers[i]->Map(0, &readRange, reinterpret_cast<void**>(&mappedQuads[i]));
+        if (FAILED(hr)) throw std::runtime_error("failed to map overlay instance buffer");
+
+        instanceViews[i].BufferLocation = instanceBuffers[i]->GetGPUVirtualAddress();
+        instanceViews[i].StrideInBytes = sizeof(OverlayQuad);
+        instanceViews[i].SizeInBytes = (UINT)bufDesc.Width;
+    }
+}
+
+void Overlay::createRootSignature() {
+    D3D12_DESCRIPTOR_RANGE atlasRange{};
+    atlasRange.RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
+    atlasRange.NumDescriptors = 1;
+    atlasRange.BaseShaderRegister = 0;
+    atlasRange.RegisterSpace = 0;
+    atlasRange.OffsetInDescriptorsFromTableStart = 0;
+
+    D3D12_ROOT_PARAMETER parameters[2]{};
+    parameters[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+    parameters[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_VERTEX;
+    parameters[0].Constants.ShaderRegister = 0;
+    parameters[0].Constants.RegisterSpace = 0;
+    parameters[0].Constants.Num32BitValues = 2;
+
+    parameters[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+    parameters[1].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
+    parameters[1].DescriptorTable.NumDescriptorRanges = 1;
+    parameters[1].DescriptorTable.pDescriptorRanges = &atlasRange;
+
+    D3D12_STATIC_SAMPLER_DESC sampler{};
+    sampler.Filter = D3D12_FILTER_MIN_MAG_MIP_POINT;
+    sampler.AddressU = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+    sampler.AddressV = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+    sampler.AddressW = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+    sampler.MaxLOD = D3D12_FLOAT32_MAX;
+    sampler.ShaderRegister = 0;
+    sampler.RegisterSpace = 0;
+    sampler.ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
+
+    D3D12_ROOT_SIGNATURE_DESC sigDesc{};
+    sigDesc.NumParameters = _countof(parameters);
+    sigDesc.pParameters = parameters;
+    sigDesc.NumStaticSamplers = 1;
+    sigDesc.pStaticSamplers = &sampler;
+    sigDesc.Flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
+
+    ComPtr<ID3DBlob> sigBlob;
+    ComPtr<ID3DBlob> errBlob;
+
+    HRESULT hr = D3D12SerializeRootSignature(
+        &sigDesc,
+        D3D_ROOT_SIGNATURE_VERSION_1,
+        sigBlob.GetAddressOf(),
+        errBlob.GetAddressOf()
+    );
+    if (FAILED(hr)) {
+        throw std::runtime_error("failed to serialize overlay root signature");
+    }
+
+    hr = device->CreateRootSignature(
+        0,
+        sigBlob->GetBufferPointer(),
+        sigBlob->GetBufferSize(),
+        IID_PPV_ARGS(rootSignature.GetAddressOf())
+    );
+    if (FAILED(hr)) {
+        throw std::runtime_error("failed to create overlay root signature");
+    }
+}
+
+void Overlay::createPipelineState() {
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC pso{};
+    pso.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+
+    pso.SampleMask = UINT_MAX;
+    pso.NumRenderTargets = 1;
+    pso.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
+    pso.SampleDesc.Count = 1;
+
+    pso.pRootSignature = rootSignature.Get();
+
+    pso.VS.pShaderBytecode = g_overlay_vs;
+    pso.VS.BytecodeLength = sizeof(g_overlay_vs);
+
+    pso.PS.pShaderBytecode = g_overlay_ps;
+    pso.PS.BytecodeLength = sizeof(g_overlay_ps);
+
+    pso.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
+    pso.RasterizerState.CullMode = D3D12_CULL_MODE_NONE;
+
+    pso.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
+    D3D12_RENDER_TARGET_BLEND_DESC& blend = pso.BlendState.RenderTarget[0];
+    blend.BlendEnable = TRUE;
+    blend.SrcBlend = D3D12_BLEND_SRC_ALPHA;
+    blend.DestBlend = D3D12_BLEND_INV_SRC_ALPHA;
+    blend.BlendOp = D3D12_BLEND_OP_ADD;
+    blend.SrcBlendAlpha = D3D12_BLEND_ONE;
+    blend.DestBlendAlpha = D3D12_BLEND_INV_SRC_ALPHA;
+    blend.BlendOpAlpha = D3D12_BLEND_OP_ADD;
+
+    pso.DepthStencilState.DepthEnable   = FALSE;
+    pso.DepthStencilState.StencilEnable = FALSE;
+
+    pso.InputLayout = PipelineInputLayout<OverlayQuad::Layout>::desc();
+
+    HRESULT hr = device->CreateGraphicsPipelineState(
+        &pso,
+        IID_PPV_ARGS(pipelineState.GetAddressOf())
+    );
+    if (FAILED(hr)) throw std::runtime_error("failed to create overlay pipeline state");
+}
+
+void Overlay::begin(UINT64 frameIdx) {
+    slot = (UINT)(frameIdx % frameCount);
+    quadCount = 0;
+    bounds = {};
+}
+
+void Overlay::push(const OverlayQuad& quad) {
+    if (quadCount >= maxQuads) return;
+
+    // Upload memory is write-combined: write whole quads, never read back.
+    mappedQuads[slot][quadCount++] = quad;
+
+    RECT rect{
+        (LONG)quad.rect.x,
+        (LONG)quad.rect.y,
+        (LONG)(quad.rect.x + quad.rect.z) + 1,
+        (LONG)(quad.rect.y + quad.rect.w) + 1
+    };
+    if (quadCount == 1) {
+        bounds = rect;
+    } else {
+        bounds.left = std::min(bounds.left, rect.left);
+        bounds.top = std::min(bounds.top, rect.top);
+        bounds.right = std::max(bounds.right, rect.right);
+        bounds.bottom = std::max(bounds.bottom, rect.bottom);
+    }
+}
+
+void Overlay::addQuad(float x, float y, float w, float h, Unorm8x4 color) {
+    // Sample the centre of the solid DEL cell so untextured quads are opaque.
+    const int glyph = 0x7F - overlayFontFirstChar;
+    const float u = ((glyph % atlasColumns) * 8 + 4) / (float)atlasWidth;
+    const float v = ((glyph / atlasColumns) * 8 + 4) / (float)atlasHeight;
+
+    push({{x, y, w, h}, {u, v, u, v}, color});
+}
+
+float Overlay::addText(float x, float y, std::string_view text, Unorm8x4 color, float scale) {
+    const float size = overlayFontCellSize * scale;
+    const float advance = glyphAdvance * scale;
+    const float startX = x;
+
+    for (char c : text) {
+        if (c == '\n') {
+            x = startX;
+            y += size;
+            continue;
+        }
+
+        int glyph = (unsigned char)c - overlayFontFirstChar;
+        if (glyph < 0 || glyph >= overlayFontCharCount - 1) {
+            glyph = '?' - overlayFontFirstChar;
+        }
+
+        if (c != ' ') {
+            const UINT cellX = (glyph % atlasColumns) * 8;
+            const UINT cellY = (glyph / atlasColumns) * 8;
+
+            push({
+                {x, y, size, size},
+                {
+                    cellX / (float)atlasWidth,
+                    cellY / (float)atlasHeight,
+                    (cellX + 8) / (float)atlasWidth,
+                    (cellY + 8) / (float)atlasHeight
+                },
+                color
+            });
+        }
+        x += advance;
+    }
+
+    return x;
+}
+
+void Overlay::addGraph(float x, float y, float w, float h, const float* values, UINT count, float maxValue, Unorm8x4 color) {
+    if (count == 0 || maxValue <= 0.f) return;
+
+    addQuad(x, y, w, h, overlayColor(0, 0, 0, 128));
+
+    const float barWidth = w / count;
+    for (UINT i = 0; i < count; i++) {
+        float barHeight = std::min(values[i] / maxValue, 1.f) * h;
+        addQuad(x + i * barWidth, y + h - barHeight, barWidth, barHeight, color);
+    }
+}
+
+void Overlay::record(ID3D12GraphicsCommandList1* commandList, UINT viewWidth, UINT viewHeight) {
+    if (quadCount == 0) return;
+
+    float invViewSize[2] = {1.f / viewWidth, 1.f / viewHeight};
+
+    ID3D12DescriptorHeap* heaps[] = {srvHeap.Get()};
+    commandList->SetDescriptorHeaps(_countof(heaps), heaps);
+
+    commandList->SetPipelineState(pipelineState.Get());
+    commandList->SetGraphicsRootSignature(rootSignature.Get());
+    commandList->SetGraphicsRoot32BitConstants(0, 2, invViewSize, 0);
+    commandList->SetGraphicsRootDescriptorTable(1, srvHeap->GetGPUDescriptorHandleForHeapStart());
+
+    commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+    commandList->IASetVertexBuffers(0, 1, &instanceViews[slot]);
+
+    commandList->DrawInstanced(4, quadCount, 0, 0);
+}
+
+UINT Overlay::getQuadCount() {
+    return quadCount;
+}
+
+RECT Overlay::getBounds() {
+    return bounds;
+}
@@ -0,0 +1,89 @@
+#ifndef OVERLAY_H_
+#define OVERLAY_H_
+
+#include "vertex_layout.h"
+#include "release_queue.h"
+
+#include <wrl.h>
+#include <d3d12.h>
+#include <string_view>
+
+using Microsoft::WRL::ComPtr;
+
+// One instance of the overlay quad. Must match VSInput in OverlayVS.hlsl.
+struct OverlayQuad {
+    Float4 rect;        // x, y, w, h in pixels, origin at the top-left of the view
+    Float4 uv;          // u0, v0, u1, v1 in the glyph atlas
+    Unorm8x4 color;
+
+    using Layout = InstanceLayout<0,
+        Attribute<"RECT", Float4>,
+        Attribute<"TEXCOORD", Float4>,
+        Attribute<"COLOR", Unorm8x4>>;
+};
+static_assert(OverlayQuad::Layout::matches<OverlayQuad>(), "OverlayQuad does not match its input layout");
+
+constexpr Unorm8x4 overlayColor(uint8_t r, uint8_t g, uint8_t b, uint8_t a = 255) {
+    return {r, g, b, a};
+}
+
+// Batched 2D renderer for HUD text and graphs. Quads are written straight
+// into a persistently mapped upload buffer and drawn as one instanced
+// triangle strip, so a frame costs a single upload and a single draw no
+// matter how many glyphs it holds.
+class Overlay {
+public:
+    // Records the glyph atlas upload into commandList; the caller executes
+    // it. The staging buffer is retired to releaseQueue.
+    Overlay(ID3D12Device* device, ID3D12GraphicsCommandList1* commandList, ReleaseQueue& releaseQueue);
+
+    void begin(UINT64 frameIdx);
+
+    void addQuad(float x, float y, float w, float h, Unorm8x4 color);
+    // Returns the x coordinate just past the last glyph.
+    float addText(float x, float y, std::string_view text, Unorm8x4 color, float scale = 1.f);
+    // Bar graph of values scaled so that maxValue fills the height.
+    void addGraph(float x, float y, float w, float h, const float* values, UINT count, float maxValue, Unorm8x4 color);
+
+    void record(ID3D12GraphicsCommandList1* commandList, UINT viewWidth, UINT viewHeight);
+
+    UINT getQuadCount();
+    // Pixel rectangle covering everything added since begin().
+    RECT getBounds();
+
+    static const UINT maxQuads = 16384;
+    static const UINT glyphAdvance = 8;
+
+private:
+    void createAtlas(ID3D12GraphicsCommandList1* commandList, ReleaseQueue& releaseQueue);
+    void createInstanceBuffers();
+    void createRootSignature();
+    void createPipelineState();
+
+    void push(const OverlayQuad& quad);
+
+private:
+    static const int frameCount = 2;
+    static const UINT atlasColumns = 16;
+    static const UINT atlasRows = 6;
+    static const UINT atlasWidth = atlasColumns * 8;
+    static const UINT atlasHeight = atlasRows * 8;
+
+    ID3D12Device* device;
+
+    ComPtr<ID3D12Resource> atlas{};
+    ComPtr<ID3D12DescriptorHeap> srvHeap{};
+
+    ComPtr<ID3D12Resource> instanceBuffers[frameCount];
+    OverlayQuad* mappedQuads[frameCount]{};
+    D3D12_VERTEX_BUFFER_VIEW instanceViews[frameCount]{};
+
+    ComPtr<ID3D12RootSignature> rootSignature{};
+    ComPtr<ID3D12PipelineState> pipelineState{};
+
+    UINT slot = 0;
+    UINT quadCount = 0;
+    RECT bounds{};
+};
+
+#endif
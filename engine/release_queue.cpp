@@ -0,0 +1,70 @@
+#include "release_queue.h"
+
+#include <algorithm>
+#include <iterator>
+
+void ReleaseQueue::retire(ComPtr<IUnknown> object) {
+    if (object == nullptr) return;
+    unsubmitted.push_back({0, std::move(object), nullptr});
+}
+
+void ReleaseQueue::retire(ComPtr<IUnknown> object, UINT64 fenceValue) {
+    if (object == nullptr) return;
+    push({fenceValue, std::move(object), nullptr});
+}
+
+void ReleaseQueue::defer(std::function<void()> release) {
+    unsubmitted.push_back({0, nullptr, std::move(release)});
+}
+
+void ReleaseQueue::defer(std::function<void()> release, UINT64 fenceValue) {
+    push({fenceValue, nullptr, std::move(release)});
+}
+
+void ReleaseQueue::submit(UINT64 fenceValue) {
+    for (Entry& entry : unsubmitted) {
+        entry.fenceValue = fenceValue;
+        push(std::move(entry));
+    }
+    unsubmitted.clear();
+}
+
+void ReleaseQueue::push(Entry&& entry) {
+    // Retiring for an older fence than the newest entry is rare (a view idle
+    // for a few frames), so a sorted insert from the back is cheap.
+    auto it = entries.end();
+    while (it != entries.begin() && std::prev(it)->fenceValue > entry.fenceValue) {
+        --it;
+    }
+    entries.insert(it, std::move(entry));
+}
+
+void ReleaseQueue::releaseEntry(Entry& entry) {
+    entry.object.Reset();
+    if (entry.release) {
+        entry.release();
+    }
+}
+
+void ReleaseQueue::collect(UINT64 completedValue) {
+    while (!entries.empty() && entries.front().fenceValue <= completedValue) {
+        releaseEntry(entries.front());
+        entries.pop_front();
+    }
+}
+
+bool ReleaseQueue::isEmpty() {
+    return entries.empty() && unsubmitted.empty();
+}
+
+void ReleaseQueue::releaseAll() {
+    for (Entry& entry : entries) {
+        releaseEntry(entry);
+    }
+    entries.clear();
+
+    for (Entry& entry : unsubmitted) {
+        releaseEntry(entry);
+    }
+    unsubmitted.clear();
+}
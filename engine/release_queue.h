@@ -0,0 +1,52 @@
+#ifndef RELEASE_QUEUE_H_
+#define RELEASE_QUEUE_H_
+
+#include <wrl.h>
+#include <deque>
+#include <functional>
+#include <vector>
+
+using Microsoft::WRL::ComPtr;
+
+// Keeps GPU objects alive until the fence value of the submission that last
+// used them has completed, so nothing has to drain the queue before letting
+// go of a resource. Entries are freed in batches from collect(), once per
+// frame or idle tick.
+class ReleaseQueue {
+public:
+    // Last used by commands still being recorded: released once the next
+    // submit() fence value completes.
+    void retire(ComPtr<IUnknown> object);
+    // Last used by a submission that already has a fence value.
+    void retire(ComPtr<IUnknown> object, UINT64 fenceValue);
+    // Same for anything that is not a COM object, such as descriptor slots
+    // or CPU-side owners of GPU objects.
+    void defer(std::function<void()> release);
+    void defer(std::function<void()> release, UINT64 fenceValue);
+
+    // Stamps everything retired since the last submit with fenceValue.
+    void submit(UINT64 fenceValue);
+    // Frees everything whose fence value has completed.
+    void collect(UINT64 completedValue);
+    // The caller must have waited for every submission.
+    void releaseAll();
+
+    bool isEmpty();
+
+private:
+    struct Entry {
+        UINT64 fenceValue;
+        ComPtr<IUnknown> object;
+        std::function<void()> release;
+    };
+
+    void push(Entry&& entry);
+    void releaseEntry(Entry& entry);
+
+private:
+    // Ordered by fence value, so collect() stops at the first one pending.
+    std::deque<Entry> entries;
+    std::vector<Entry> unsubmitted;
+};
+
+#endif
@@ -1,6 +1,6 @@
 struct PSInput {
     float4 position : SV_POSITION;
-    uint primitiveID : SV_PrimitiveID;
+    float2 local : TEXCOORD0;
 };
 
 float4 PSMain(PSInput input) : SV_TARGET {
@@ -12,5 +12,7 @@ float4 PSMain(PSInput input) : SV_TARGET {
         float4(1.0, 0.0, 1.0, 1.0),  // Magenta
         float4(0.0, 1.0, 1.0, 1.0),  // Cyan
     };
-    return colors[input.primitiveID];
+    // One colour per 60 degree wedge between neighbouring corners.
+    float wedge = floor(atan2(input.local.y, input.local.x) / (3.14159265 / 3.0));
+    return colors[(uint)(wedge + 6.0) % 6];
 }
@@ -3,25 +3,42 @@ struct VSInput {
 };
 
 cbuffer RootConstants : register(b0) {
-    int frameIdx;
+    float animationAngle;
+    float2 cameraPos;
+    float zoom;
+    float aspect;
+}
+
+cbuffer ObjectConstants : register(b1) {
+    float2 objectPos;
+    float objectScale;
 }
 
 struct PSInput {
     float4 position : SV_POSITION;
+    // Mesh-space position, so colours follow the shape rather than the
+    // triangles of whichever LOD is drawn.
+    float2 local : TEXCOORD0;
 };
 
 PSInput VSMain(VSInput inputVertex) {
-    float angle = 2 * 3.14 * frameIdx / 120;
-
     float x = inputVertex.position.x;
     float y = inputVertex.position.y;
 
-    float cosA = cos(angle);
-    float sinA = sin(angle);
+    float cosA = cos(animationAngle);
+    float sinA = sin(animationAngle);
 
     float2 rotated;
     rotated.x = x * cosA - y * sinA;
     rotated.y = x * sinA + y * cosA;
 
-    return PSInput(float4(rotated, 0.0, 1.0));
+    float2 world = rotated * objectScale + objectPos;
+
+    float2 projected = (world - cameraPos) * zoom;
+    projected.x *= aspect;
+
+    PSInput output;
+    output.position = float4(projected, 0.0, 1.0);
+    output.local = inputVertex.position;
+    return output;
 }
@@ -0,0 +1,50 @@
+struct VSInput {
+    float2 position : POSITION;
+    // Column and row within the chunk, terrain type, height.
+    uint4 tile : TILE;
+};
+
+cbuffer RootConstants : register(b0) {
+    float animationAngle;
+    float2 cameraPos;
+    float zoom;
+    float aspect;
+}
+
+cbuffer ChunkConstants : register(b1) {
+    float2 chunkOrigin;
+    float tileScale;
+}
+
+struct PSInput {
+    float4 position : SV_POSITION;
+    float4 color : COLOR;
+};
+
+static const float4 terrainColors[6] = {
+    float4(0.10, 0.30, 0.70, 1.0),  // Water
+    float4(0.85, 0.80, 0.55, 1.0),  // Sand
+    float4(0.35, 0.65, 0.25, 1.0),  // Grass
+    float4(0.15, 0.40, 0.15, 1.0),  // Forest
+    float4(0.50, 0.45, 0.40, 1.0),  // Rock
+    float4(0.95, 0.95, 0.95, 1.0),  // Snow
+};
+
+PSInput VSMain(VSInput input) {
+    // Flat-topped hexagons in odd-q offset layout; the mesh has a
+    // circumradius of 0.5 at scale 1.
+    float radius = 0.5 * tileScale;
+    float2 centre;
+    centre.x = 1.5 * radius * input.tile.x;
+    centre.y = 1.7320508 * radius * (input.tile.y + 0.5 * (input.tile.x & 1));
+
+    float2 world = chunkOrigin + centre + input.position * tileScale;
+
+    float2 projected = (world - cameraPos) * zoom;
+    projected.x *= aspect;
+
+    PSInput output;
+    output.position = float4(projected, 0.0, 1.0);
+    output.color = terrainColors[min(input.tile.z, 5)] * (0.75 + 0.25 * input.tile.w / 255.0);
+    return output;
+}
@@ -0,0 +1,13 @@
+Texture2D<float> glyphAtlas : register(t0);
+SamplerState pointSampler : register(s0);
+
+struct PSInput {
+    float4 position : SV_POSITION;
+    float2 uv : TEXCOORD;
+    float4 color : COLOR;
+};
+
+float4 PSMain(PSInput input) : SV_TARGET {
+    float coverage = glyphAtlas.Sample(pointSampler, input.uv);
+    return float4(input.color.rgb, input.color.a * coverage);
+}
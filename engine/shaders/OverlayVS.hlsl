@@ -0,0 +1,30 @@
+struct VSInput {
+    float4 rect : RECT;
+    float4 uv : TEXCOORD;
+    float4 color : COLOR;
+    uint vertexID : SV_VertexID;
+};
+
+cbuffer OverlayConstants : register(b0) {
+    float2 invViewSize;
+}
+
+struct PSInput {
+    float4 position : SV_POSITION;
+    float2 uv : TEXCOORD;
+    float4 color : COLOR;
+};
+
+PSInput VSMain(VSInput input) {
+    // Triangle strip corners: (0,0) (1,0) (0,1) (1,1).
+    float2 corner = float2(input.vertexID & 1, input.vertexID >> 1);
+
+    float2 pixel = input.rect.xy + corner * input.rect.zw;
+    float2 clip = pixel * invViewSize * 2.0 - 1.0;
+
+    PSInput output;
+    output.position = float4(clip.x, -clip.y, 0.0, 1.0);
+    output.uv = lerp(input.uv.xy, input.uv.zw, corner);
+    output.color = input.color;
+    return output;
+}
@@ -0,0 +1,105 @@
+#include "task_graph.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+TaskGraph::TaskId TaskGraph::add(const char* name, std::function<void()> work, std::initializer_list<TaskId> dependencies) {
+    TaskId id = tasks.size();
+
+    Task task;
+    task.name = name;
+    task.work = std::move(work);
+    task.pendingDependencies = dependencies.size();
+    tasks.push_back(std::move(task));
+
+    for (TaskId dependency : dependencies) {
+        if (dependency >= id) {
+            throw std::invalid_argument("task dependency must be added first");
+        }
+        tasks[dependency].dependents.push_back(id);
+    }
+
+    return id;
+}
+
+void TaskGraph::run(unsigned threads) {
+    using Clock = std::chrono::steady_clock;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<TaskId> ready;
+    size_t remaining = tasks.size();
+    std::exception_ptr failure;
+
+    const Clock::time_point start = Clock::now();
+    auto elapsed = [&] {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    };
+
+    timings.clear();
+    for (TaskId id = 0; id < tasks.size(); id++) {
+        if (tasks[id].pendingDependencies == 0) {
+            ready.push_back(id);
+        }
+    }
+
+    auto worker = [&](unsigned index) {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        while (true) {
+            wake.wait(lock, [&] { return !ready.empty() || remaining == 0 || failure; });
+            if (remaining == 0 || failure) return;
+
+            TaskId id = ready.front();
+            ready.pop_front();
+
+            lock.unlock();
+            const double taskStart = elapsed();
+            std::exception_ptr error;
+            try {
+                tasks[id].work();
+            } catch (...) {
+                error = std::current_exception();
+            }
+            const double taskEnd = elapsed();
+            lock.lock();
+
+            remaining--;
+            timings.push_back({tasks[id].name, taskStart, taskEnd, index});
+
+            if (error && !failure) {
+                failure = error;
+            }
+            for (TaskId dependent : tasks[id].dependents) {
+                if (--tasks[dependent].pendingDependencies == 0) {
+                    ready.push_back(dependent);
+                }
+            }
+            wake.notify_all();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    const unsigned count = threads > 0 ? threads : 1;
+    for (unsigned i = 1; i < count; i++) {
+        workers.emplace_back(worker, i);
+    }
+    worker(0);
+
+    for (std::thread& thread : workers) {
+        thread.join();
+    }
+
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
+
+const std::vector<TaskGraph::Timing>& TaskGraph::getTimings() {
+    return timings;
+}
@@ -0,0 +1,43 @@
+#ifndef TASK_GRAPH_H_
+#define TASK_GRAPH_H_
+
+#include <functional>
+#include <initializer_list>
+#include <vector>
+
+// Runs a set of tasks with dependencies on a small pool of worker threads.
+// Every task starts as soon as all of its dependencies have finished.
+class TaskGraph {
+public:
+    using TaskId = size_t;
+
+    struct Timing {
+        const char* name;
+        double startMilliseconds;
+        double endMilliseconds;
+        unsigned worker;
+    };
+
+    TaskId add(const char* name, std::function<void()> work, std::initializer_list<TaskId> dependencies = {});
+
+    // Blocks until every task has run. If a task throws, no further tasks
+    // are started and the first exception is rethrown once the running
+    // ones are done.
+    void run(unsigned threads);
+
+    // Timings relative to the start of run(), in task completion order.
+    const std::vector<Timing>& getTimings();
+
+private:
+    struct Task {
+        const char* name;
+        std::function<void()> work;
+        std::vector<TaskId> dependents;
+        size_t pendingDependencies = 0;
+    };
+
+    std::vector<Task> tasks;
+    std::vector<Timing> timings;
+};
+
+#endif
@@ -0,0 +1,109 @@
+#include "thread_pool.h"
+#include "frame_arena.h"
+#include "allocation_audit.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned threads) {
+    for (unsigned i = 1; i < threads; i++) {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+unsigned ThreadPool::getThreadCount() {
+    return (unsigned)workers.size() + 1;
+}
+
+void ThreadPool::run(size_t count, size_t minChunk, void* context, ChunkFunction function) {
+    if (count == 0) return;
+
+    const size_t threads = workers.size() + 1;
+    // A few chunks per thread so uneven items still balance out.
+    const size_t chunk = std::max<size_t>(std::max<size_t>(minChunk, 1), (count + threads * 4 - 1) / (threads * 4));
+
+    if (workers.empty() || chunk >= count) {
+        function(context, 0, count);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobContext = context;
+        jobFunction = function;
+        jobCount = count;
+        jobChunk = chunk;
+        nextItem = 0;
+        failure = nullptr;
+        busyWorkers = (unsigned)workers.size();
+        generation++;
+    }
+    wake.notify_all();
+
+    runChunks();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return busyWorkers == 0; });
+    jobContext = nullptr;
+    jobFunction = nullptr;
+
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
+
+void ThreadPool::runChunks() {
+    while (true) {
+        const size_t begin = nextItem.fetch_add(jobChunk);
+        if (begin >= jobCount) return;
+
+        try {
+            jobFunction(jobContext, begin, std::min(begin + jobChunk, jobCount));
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!failure) {
+                failure = std::current_exception();
+            }
+            // Skip whatever is left of the job.
+            nextItem = jobCount;
+        }
+    }
+}
+
+void ThreadPool::workerLoop() {
+    uint64_t seen = 0;
+
+    // Create the worker's frame arena up front rather than inside whichever
+    // frame first hands it a chunk. Its allocations belong to the frame that
+    // handed it the job, so they are audited with the render thread's.
+    frameArena();
+    auditAllocationsOnThisThread();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [&] { return stopping || generation != seen; });
+        if (stopping) return;
+
+        seen = generation;
+        lock.unlock();
+        // Nothing from an earlier job is still in use here.
+        syncFrameArena();
+        runChunks();
+        lock.lock();
+
+        if (--busyWorkers == 0) {
+            done.notify_one();
+        }
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Persistent workers for splitting per-frame loops across cores. The calling
+// thread takes part in every job, so a pool of one thread runs inline.
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned threads);
+    ~ThreadPool();
+
+    // Calls work(begin, end) on chunks of [0, count) of at least minChunk
+    // items and returns once all of them are done. Rethrows the first
+    // exception thrown by a chunk. work is only referenced, never copied, so
+    // a frame can use the pool without allocating.
+    template <class Work>
+    void parallelFor(size_t count, size_t minChunk, Work&& work) {
+        using Callable = std::remove_reference_t<Work>;
+        run(count, minChunk, const_cast<void*>(static_cast<const void*>(&work)), [](void* context, size_t begin, size_t end) {
+            (*static_cast<Callable*>(context))(begin, end);
+        });
+    }
+
+    unsigned getThreadCount();
+
+private:
+    using ChunkFunction = void (*)(void* context, size_t begin, size_t end);
+
+    void run(size_t count, size_t minChunk, void* context, ChunkFunction function);
+    void workerLoop();
+    void runChunks();
+
+private:
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    void* jobContext = nullptr;
+    ChunkFunction jobFunction = nullptr;
+    size_t jobCount = 0;
+    size_t jobChunk = 0;
+    std::atomic<size_t> nextItem = 0;
+    uint64_t generation = 0;
+    unsigned busyWorkers = 0;
+    bool stopping = false;
+    std::exception_ptr failure;
+};
+
+#endif
@@ -1,8 +1,33 @@
 #ifndef TYPES_H_
 #define TYPES_H_
 
+#include "vertex_layout.h"
+
+// CPU-side mesh vertex used while building and simplifying geometry.
 struct Vertex {
     float x, y;
 };
 
+// What the hexagon vertex buffer holds: positions quantized to half floats,
+// half the size of Vertex. Must match VSInput in ConstColorVS.hlsl.
+struct PackedVertex {
+    Half2 position;
+
+    using Layout = VertexLayout<Attribute<"POSITION", Half2>>;
+};
+static_assert(PackedVertex::Layout::matches<PackedVertex>(), "PackedVertex does not match its input layout");
+
+// Axis-aligned rectangle in world units, y up.
+struct WorldRect {
+    float minX, minY, maxX, maxY;
+};
+
+enum DirtyFlags : unsigned int {
+    DirtyNone   = 0,
+    DirtyScene  = 1 << 0,
+    DirtyCamera = 1 << 1,
+    DirtyWindow = 1 << 2,
+    DirtyWorld  = 1 << 3,
+};
+
 #endif
@@ -0,0 +1,161 @@
+#ifndef VERTEX_LAYOUT_H_
+#define VERTEX_LAYOUT_H_
+
+#include <d3d12.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Attribute storage types. Each one maps to exactly one DXGI format through
+// VertexFormat, so a vertex struct built from them fully describes what the
+// input assembler reads.
+struct Float2 { float x, y; };
+struct Float3 { float x, y, z; };
+struct Float4 { float x, y, z, w; };
+struct Half2 { uint16_t x, y; };
+struct Half4 { uint16_t x, y, z, w; };
+struct Snorm16x2 { int16_t x, y; };
+struct Snorm16x4 { int16_t x, y, z, w; };
+struct Unorm8x4 { uint8_t x, y, z, w; };
+struct Uint8x4 { uint8_t x, y, z, w; };
+struct Snorm8x4 { int8_t x, y, z, w; };
+
+template <typename T>
+struct VertexFormat;
+
+template <> struct VertexFormat<Float2> { static constexpr DXGI_FORMAT value = DXGI_FORMAT_R32G32_FLOAT; };
+template <> struct VertexFormat<Float3> { static constexpr DXGI_FORMAT value = DXGI_FORMAT_R32G32B32_FLOAT; };
+template <> struct VertexFormat<Float4> { static constexpr DXGI_FORMAT value = DXGI_FORMAT_R32G32B32A32_FLOAT; };
+template <> struct VertexFormat<Half2> { static constexpr DXGI_FORMAT value = DXGI_FORMAT_R16G16_FLOAT; };
+template <> struct VertexFormat<Half4> { static constexpr DXGI_FORMAT value = DXGI_FORMAT_R16G16B16A16_FLOAT; };
+template <> struct VertexFormat<Snorm16x2> { static constexpr DXGI_FORMAT value = DXGI_FORMAT_R16G16_SNORM; };
+template <> struct VertexFormat<Snorm16x4> { static constexpr DXGI_FORMAT value = DXGI_FORMAT_R16G16B16A16_SNORM; };
+template <> struct VertexFormat<Unorm8x4> { static constexpr DXGI_FORMAT value = DXGI_FORMAT_R8G8B8A8_UNORM; };
+template <> struct VertexFormat<Uint8x4> { static constexpr DXGI_FORMAT value = DXGI_FORMAT_R8G8B8A8_UINT; };
+template <> struct VertexFormat<Snorm8x4> { static constexpr DXGI_FORMAT value = DXGI_FORMAT_R8G8B8A8_SNORM; };
+
+template <size_t N>
+struct SemanticName {
+    char value[N];
+
+    constexpr SemanticName(const char (&name)[N]) {
+        std::copy_n(name, N, value);
+    }
+};
+
+template <SemanticName Name, typename T, UINT Index = 0>
+struct Attribute {
+    using Type = T;
+
+    static constexpr const char* semantic = Name.value;
+    static constexpr UINT semanticIndex = Index;
+    static constexpr DXGI_FORMAT format = VertexFormat<T>::value;
+};
+
+namespace vertex_layout_detail {
+
+// Member types of an aggregate, recovered with structured bindings.
+template <typename V, typename... Types>
+constexpr bool membersAre() {
+    constexpr size_t count = sizeof...(Types);
+    using List = std::tuple<Types...>;
+    V v{};
+
+    if constexpr (count == 1) {
+        auto& [a] = v;
+        return std::is_same_v<std::remove_cvref_t<decltype(a)>, std::tuple_element_t<0, List>>;
+    } else if constexpr (count == 2) {
+        auto& [a, b] = v;
+        return std::is_same_v<std::remove_cvref_t<decltype(a)>, std::tuple_element_t<0, List>>
+            && std::is_same_v<std::remove_cvref_t<decltype(b)>, std::tuple_element_t<1, List>>;
+    } else if constexpr (count == 3) {
+        auto& [a, b, c] = v;
+        return std::is_same_v<std::remove_cvref_t<decltype(a)>, std::tuple_element_t<0, List>>
+            && std::is_same_v<std::remove_cvref_t<decltype(b)>, std::tuple_element_t<1, List>>
+            && std::is_same_v<std::remove_cvref_t<decltype(c)>, std::tuple_element_t<2, List>>;
+    } else if constexpr (count == 4) {
+        auto& [a, b, c, d] = v;
+        return std::is_same_v<std::remove_cvref_t<decltype(a)>, std::tuple_element_t<0, List>>
+            && std::is_same_v<std::remove_cvref_t<decltype(b)>, std::tuple_element_t<1, List>>
+            && std::is_same_v<std::remove_cvref_t<decltype(c)>, std::tuple_element_t<2, List>>
+            && std::is_same_v<std::remove_cvref_t<decltype(d)>, std::tuple_element_t<3, List>>;
+    } else {
+        static_assert(count <= 4, "vertex layouts support up to four attributes");
+        return false;
+    }
+}
+
+}
+
+// Input layout for one vertex buffer slot, generated from its attribute
+// list. Offsets are packed in declaration order with no padding.
+template <UINT Slot, D3D12_INPUT_CLASSIFICATION Classification, typename... Attributes>
+struct InputLayout {
+    static constexpr UINT count = sizeof...(Attributes);
+    static constexpr UINT stride = (0 + ... + (UINT)sizeof(typename Attributes::Type));
+
+    static constexpr std::array<UINT, count> offsets = [] {
+        std::array<UINT, count> result{};
+        const UINT sizes[] = {(UINT)sizeof(typename Attributes::Type)...};
+        UINT offset = 0;
+        for (UINT i = 0; i < count; i++) {
+            result[i] = offset;
+            offset += sizes[i];
+        }
+        return result;
+    }();
+
+    static constexpr std::array<D3D12_INPUT_ELEMENT_DESC, count> elements = []<size_t... I>(std::index_sequence<I...>) {
+        return std::array<D3D12_INPUT_ELEMENT_DESC, count>{{
+            {
+                Attributes::semantic,
+                Attributes::semanticIndex,
+                Attributes::format,
+                Slot,
+                offsets[I],
+                Classification,
+                Classification == D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA ? 1u : 0u
+            }...
+        }};
+    }(std::index_sequence_for<Attributes...>{});
+
+    // True when V is an aggregate whose members are exactly the attribute
+    // types, in order, without padding, i.e. the GPU reads what the CPU
+    // writes.
+    template <typename V>
+    static constexpr bool matches() {
+        return sizeof(V) == stride
+            && std::is_standard_layout_v<V>
+            && vertex_layout_detail::membersAre<V, typename Attributes::Type...>();
+    }
+};
+
+template <typename... Attributes>
+using VertexLayout = InputLayout<0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, Attributes...>;
+
+template <UINT Slot, typename... Attributes>
+using InstanceLayout = InputLayout<Slot, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, Attributes...>;
+
+// Concatenates the elements of several slots into one pipeline input layout.
+template <typename... Layouts>
+struct PipelineInputLayout {
+    static constexpr UINT count = (0 + ... + Layouts::count);
+
+    static constexpr std::array<D3D12_INPUT_ELEMENT_DESC, count> elements = [] {
+        std::array<D3D12_INPUT_ELEMENT_DESC, count> result{};
+        UINT i = 0;
+        ((std::copy(Layouts::elements.begin(), Layouts::elements.end(), result.begin() + i), i += Layouts::count), ...);
+        return result;
+    }();
+
+    static D3D12_INPUT_LAYOUT_DESC desc() {
+        return {elements.data(), count};
+    }
+};
+
+#endif
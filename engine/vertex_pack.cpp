@@ -0,0 +1,85 @@
+#include "vertex_pack.h"
+
+#include <cstring>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define VERTEX_PACK_SSE2 1
+#endif
+
+uint16_t toHalf(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    const uint32_t sign = (bits >> 16) & 0x8000;
+    bits &= 0x7FFFFFFF;
+
+    // NaN stays NaN; too large rounds to infinity.
+    if (bits > 0x7F800000) return (uint16_t)(sign | 0x7E00);
+    if (bits >= 0x47800000) return (uint16_t)(sign | 0x7C00);
+
+    // Denormal results: let the FPU do the rounding by adding 0.5.
+    if (bits < 0x38800000) {
+        float f;
+        std::memcpy(&f, &bits, sizeof(f));
+        f += 0.5f;
+        uint32_t denormal;
+        std::memcpy(&denormal, &f, sizeof(denormal));
+        return (uint16_t)(sign | (denormal - 0x3F000000));
+    }
+
+    // Rebias the exponent and round to nearest even.
+    const uint32_t odd = (bits >> 13) & 1;
+    bits += 0xC8000FFF + odd;
+    return (uint16_t)(sign | (bits >> 13));
+}
+
+void packHalf(const float* src, uint16_t* dst, size_t count) {
+    size_t i = 0;
+
+#ifdef VERTEX_PACK_SSE2
+    // Same steps as toHalf(), four lanes at a time with integer ops only,
+    // so no F16C requirement.
+    const __m128i signMask = _mm_set1_epi32(0x80000000);
+    const __m128i infinity = _mm_set1_epi32(0x47800000);
+    const __m128i denormalLimit = _mm_set1_epi32(0x38800000);
+    const __m128 denormalMagic = _mm_castsi128_ps(_mm_set1_epi32(0x3F000000));
+    const __m128i rebias = _mm_set1_epi32(0xC8000FFF);
+    const __m128i one = _mm_set1_epi32(1);
+    const __m128i nanLimit = _mm_set1_epi32(0x7F800000);
+    const __m128i halfInf = _mm_set1_epi32(0x7C00);
+    const __m128i halfNan = _mm_set1_epi32(0x7E00);
+
+    for (; i + 4 <= count; i += 4) {
+        __m128i bits = _mm_castps_si128(_mm_loadu_ps(src + i));
+        __m128i sign = _mm_and_si128(bits, signMask);
+        bits = _mm_xor_si128(bits, sign);
+
+        __m128i isNan = _mm_cmpgt_epi32(bits, nanLimit);
+        __m128i isInf = _mm_cmpgt_epi32(bits, _mm_sub_epi32(infinity, one));
+        __m128i isDenormal = _mm_cmplt_epi32(bits, denormalLimit);
+
+        __m128i denormal = _mm_sub_epi32(
+            _mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(bits), denormalMagic)),
+            _mm_castps_si128(denormalMagic)
+        );
+
+        __m128i odd = _mm_and_si128(_mm_srli_epi32(bits, 13), one);
+        __m128i normal = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(bits, rebias), odd), 13);
+
+        __m128i result = _mm_or_si128(_mm_and_si128(isDenormal, denormal), _mm_andnot_si128(isDenormal, normal));
+        result = _mm_or_si128(_mm_and_si128(isInf, halfInf), _mm_andnot_si128(isInf, result));
+        result = _mm_or_si128(_mm_and_si128(isNan, halfNan), _mm_andnot_si128(isNan, result));
+        result = _mm_or_si128(result, _mm_srli_epi32(sign, 16));
+
+        // Narrow to 16 bits: sign extension from the shift keeps packs_epi32
+        // from saturating.
+        result = _mm_srai_epi32(_mm_slli_epi32(result, 16), 16);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i), _mm_packs_epi32(result, result));
+    }
+#endif
+
+    for (; i < count; i++) {
+        dst[i] = toHalf(src[i]);
+    }
+}
@@ -0,0 +1,14 @@
+#ifndef VERTEX_PACK_H_
+#define VERTEX_PACK_H_
+
+#include <cstddef>
+#include <cstdint>
+
+// Bulk conversion of float vertex positions to half floats. Uses SSE2 four
+// lanes at a time where available; values out of range become infinity.
+// Rounding is to nearest even, matching the SIMD and scalar paths.
+void packHalf(const float* src, uint16_t* dst, size_t count);
+
+uint16_t toHalf(float value);
+
+#endif
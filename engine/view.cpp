@@ -0,0 +1,300 @@
+#include "view.h"
+
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+bool isEmpty(const RECT& rect) {
+    return rect.left >= rect.right || rect.top >= rect.bottom;
+}
+
+RECT unite(const RECT& a, const RECT& b) {
+    if (isEmpty(a)) return b;
+    if (isEmpty(b)) return a;
+
+    return {
+        std::min(a.left, b.left),
+        std::min(a.top, b.top),
+        std::max(a.right, b.right),
+        std::max(a.bottom, b.bottom)
+    };
+}
+
+RECT intersect(const RECT& a, const RECT& b) {
+    RECT rect{
+        std::max(a.left, b.left),
+        std::max(a.top, b.top),
+        std::min(a.right, b.right),
+        std::min(a.bottom, b.bottom)
+    };
+    return isEmpty(rect) ? RECT{} : rect;
+}
+
+}
+
+View::View(IDXGIFactory4* dxgiFactory, ID3D12Device* device, ID3D12CommandQueue* commandQueue, HWND hwnd)
+    : device(device), hwnd(hwnd) {
+    createSwapChain(dxgiFactory, commandQueue);
+    createRenderTargetView();
+    createBarriers();
+    createVpAndSc();
+}
+
+void View::createSwapChain(IDXGIFactory4* dxgiFactory, ID3D12CommandQueue* commandQueue) {
+    HRESULT hr;
+
+    // Zero width and height take the size of the window's client area.
+    swapChainDesc.Width = 0;
+    swapChainDesc.Height = 0;
+    swapChainDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    swapChainDesc.BufferCount = bufferCount;
+    swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
+    // Sequential flip keeps back buffer contents between presents, which
+    // partial clears and dirty rectangle presents rely on.
+    swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_SEQUENTIAL;
+    swapChainDesc.SampleDesc.Count = 1;
+
+    ComPtr<IDXGISwapChain1> swapChain1;
+    hr = dxgiFactory->CreateSwapChainForHwnd(
+        commandQueue,
+        hwnd,
+        &swapChainDesc,
+        nullptr,
+        nullptr,
+        swapChain1.GetAddressOf()
+    );
+    if (FAILED(hr)) {
+        throw std::runtime_error("failed to create swap chain");
+    }
+    dxgiFactory->MakeWindowAssociation(hwnd, DXGI_MWA_NO_ALT_ENTER);
+
+    hr = swapChain1.As(&swapChain);
+    if (FAILED(hr)) {
+        throw std::runtime_error("failed to query IDXGISwapChain3");
+    }
+
+    hr = swapChain->GetDesc1(&swapChainDesc);
+    if (FAILED(hr)) {
+        throw std::runtime_error("failed to query swap chain description");
+    }
+    width = swapChainDesc.Width;
+    height = swapChainDesc.Height;
+}
+
+void View::createRenderTargetView() {
+    HRESULT hr;
+
+    D3D12_DESCRIPTOR_HEAP_DESC descrHeapDesc{};
+    descrHeapDesc.NumDescriptors = bufferCount;
+    descrHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
+
+    hr = device->CreateDescriptorHeap(&descrHeapDesc, IID_PPV_ARGS(rtvHeap.GetAddressOf()));
+    if (FAILED(hr)) {
+        throw std::runtime_error("failed to create descriptor heap");
+    }
+
+    createBackBufferViews();
+}
+
+void View::createBackBufferViews() {
+    HRESULT hr;
+
+    UINT rtvStride = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+    D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = rtvHeap->GetCPUDescriptorHandleForHeapStart();
+
+    for (UINT i = 0; i < bufferCount; ++ i) {
+        hr = swapChain->GetBuffer(i, IID_PPV_ARGS(backBuffers[i].GetAddressOf()));
+        if (FAILED(hr)) {
+            throw std::runtime_error("failed to get back buffer");
+        }
+        device->CreateRenderTargetView(backBuffers[i].Get(), nullptr, rtvHandle);
+
+        this->rtvHandle[i] = rtvHandle;
+        rtvHandle.ptr += rtvStride;
+    }
+}
+
+void View::createBarriers() {
+    for (UINT i = 0; i < bufferCount; i++) {
+        presentToRTVBarrier[i] = {};
+        presentToRTVBarrier[i].Transition.pResource   = backBuffers[i].Get();
+        presentToRTVBarrier[i].Transition.StateBefore = D3D12_RESOURCE_STATE_PRESENT;
+        presentToRTVBarrier[i].Transition.StateAfter  = D3D12_RESOURCE_STATE_RENDER_TARGET;
+
+        rtvToPresentBarrier[i] = {};
+        rtvToPresentBarrier[i].Transition.pResource   = backBuffers[i].Get();
+        rtvToPresentBarrier[i].Transition.StateBefore = D3D12_RESOURCE_STATE_RENDER_TARGET;
+        rtvToPresentBarrier[i].Transition.StateAfter  = D3D12_RESOURCE_STATE_PRESENT;
+    }
+}
+
+void View::createVpAndSc() {
+    vp.TopLeftX = 0.0f;
+    vp.TopLeftY = 0.0f;
+    vp.Width    = (float)width;
+    vp.Height   = (float)height;
+    vp.MinDepth = 0.0f;
+    vp.MaxDepth = 1.0f;
+
+    sc.left   = 0;
+    sc.top    = 0;
+    sc.right  = (LONG)width;
+    sc.bottom = (LONG)height;
+}
+
+void View::resize(UINT width, UINT height) {
+    if (width == 0 || height == 0) return;
+    if (width == this->width && height == this->height) return;
+
+    for (UINT i = 0; i < bufferCount; i++) {
+        backBuffers[i].Reset();
+    }
+
+    HRESULT hr = swapChain->ResizeBuffers(bufferCount, width, height, swapChainDesc.Format, 0);
+    if (FAILED(hr)) {
+        throw std::runtime_error("failed to resize swap chain");
+    }
+
+    this->width = width;
+    this->height = height;
+    swapChainDesc.Width = width;
+    swapChainDesc.Height = height;
+
+    createBackBufferViews();
+    createBarriers();
+    createVpAndSc();
+
+    markDirty(DirtyWindow);
+}
+
+void View::setCamera(const Camera& camera) {
+    this->camera = camera;
+    markDirty(DirtyCamera);
+}
+
+const Camera& View::getCamera() {
+    return camera;
+}
+
+void View::markDirty(UINT flags) {
+    dirtyFlags |= flags;
+}
+
+bool View::needsRender(bool continuous) {
+    return continuous || dirtyFlags != DirtyNone;
+}
+
+float View::getPixelsPerUnit() {
+    return camera.zoom * height / 2.f;
+}
+
+RECT View::toPixels(const WorldRect& rect) {
+    const float scale = getPixelsPerUnit();
+    const float cx = width / 2.f;
+    const float cy = height / 2.f;
+
+    return {
+        (LONG)std::floor(cx + (rect.minX - camera.x) * scale) - 1,
+        (LONG)std::floor(cy - (rect.maxY - camera.y) * scale) - 1,
+        (LONG)std::ceil(cx + (rect.maxX - camera.x) * scale) + 1,
+        (LONG)std::ceil(cy - (rect.minY - camera.y) * scale) + 1
+    };
+}
+
+WorldRect View::toWorld(const RECT& rect) {
+    const float scale = getPixelsPerUnit();
+    const float cx = width / 2.f;
+    const float cy = height / 2.f;
+
+    return {
+        camera.x + (rect.left - cx) / scale,
+        camera.y - (rect.bottom - cy) / scale,
+        camera.x + (rect.right - cx) / scale,
+        camera.y - (rect.top - cy) / scale
+    };
+}
+
+void View::addDamage(const RECT& rect) {
+    RECT clipped = intersect(rect, sc);
+    for (UINT i = 0; i < bufferCount; i++) {
+        bufferDamage[i] = unite(bufferDamage[i], clipped);
+    }
+    frameDamage = unite(frameDamage, clipped);
+}
+
+void View::prepareFrame(bool continuous, const WorldRect& sceneBounds) {
+    bi = swapChain->GetCurrentBackBufferIndex();
+
+    if (dirtyFlags & (DirtyWindow | DirtyCamera | DirtyWorld)) {
+        addDamage(sc);
+    }
+    if (continuous || (dirtyFlags & DirtyScene)) {
+        addDamage(toPixels(sceneBounds));
+    }
+}
+
+void View::recordBegin(ID3D12GraphicsCommandList1* commandList, const float clearColor[4]) {
+    const RECT& damage = bufferDamage[bi];
+
+    commandList->ResourceBarrier(1, &presentToRTVBarrier[bi]);
+
+    commandList->OMSetRenderTargets(1, &rtvHandle[bi], FALSE, nullptr);
+
+    commandList->ClearRenderTargetView(rtvHandle[bi], clearColor, 1, &damage);
+
+    commandList->RSSetViewports(1, &vp);
+    commandList->RSSetScissorRects(1, &damage);
+}
+
+void View::recordEnd(ID3D12GraphicsCommandList1* commandList) {
+    commandList->ResourceBarrier(1, rtvToPresentBarrier + bi);
+}
+
+void View::present(UINT syncInterval) {
+    DXGI_PRESENT_PARAMETERS presentParams{};
+    if (!(dirtyFlags & DirtyWindow) && !isEmpty(frameDamage)) {
+        presentParams.DirtyRectsCount = 1;
+        presentParams.pDirtyRects = &frameDamage;
+    }
+
+    HRESULT hr = swapChain->Present1(syncInterval, 0, &presentParams);
+    if (FAILED(hr)) {
+        throw std::runtime_error("failed to present buffer");
+    }
+
+    bufferDamage[bi] = {};
+    frameDamage = {};
+    dirtyFlags = DirtyNone;
+}
+
+ViewConstants View::getConstants(float animationAngle) {
+    return {
+        animationAngle,
+        camera.x, camera.y,
+        camera.zoom,
+        // Minimised views have no size; nothing is drawn into them anyway.
+        width > 0 ? (float)height / (float)width : 1.f
+    };
+}
+
+const RECT& View::getDamage() {
+    return bufferDamage[bi];
+}
+
+UINT View::getWidth() {
+    return width;
+}
+
+UINT View::getHeight() {
+    return height;
+}
+
+void View::setLastUsedFence(UINT64 value) {
+    lastUsedFence = value;
+}
+
+UINT64 View::getLastUsedFence() {
+    return lastUsedFence;
+}
@@ -0,0 +1,104 @@
+#ifndef VIEW_H_
+#define VIEW_H_
+
+#include "types.h"
+#include "camera.h"
+
+#include <wrl.h>
+#include <dxgi1_6.h>
+#include <d3d12.h>
+
+using Microsoft::WRL::ComPtr;
+
+// Root constants shared by every draw recorded into a view. Must match the
+// RootConstants cbuffer in ConstColorVS.hlsl.
+struct ViewConstants {
+    float animationAngle;
+    float cameraX, cameraY;
+    float zoom;
+    float aspect;
+};
+
+// A window the engine presents into: owns the swap chain, its render target
+// views and the per-view camera and damage state. Device, queue and all
+// pipelines and geometry are shared through the owning Engine.
+class View {
+public:
+    View(IDXGIFactory4* dxgiFactory, ID3D12Device* device, ID3D12CommandQueue* commandQueue, HWND hwnd);
+
+    // The GPU must be done with the back buffers before this is called.
+    void resize(UINT width, UINT height);
+
+    void setCamera(const Camera& camera);
+    const Camera& getCamera();
+
+    void markDirty(UINT flags);
+    // Adds a region to redraw without marking the view dirty.
+    void addDamage(const RECT& rect);
+    bool needsRender(bool continuous);
+
+    // Picks the back buffer for this frame and folds the pending dirty state
+    // into its damage region. sceneBounds covers everything that animates.
+    void prepareFrame(bool continuous, const WorldRect& sceneBounds);
+    void recordBegin(ID3D12GraphicsCommandList1* commandList, const float clearColor[4]);
+    void recordEnd(ID3D12GraphicsCommandList1* commandList);
+    void present(UINT syncInterval);
+
+    ViewConstants getConstants(float animationAngle);
+    // Size of one world unit on screen.
+    float getPixelsPerUnit();
+    RECT toPixels(const WorldRect& rect);
+    WorldRect toWorld(const RECT& rect);
+    const RECT& getDamage();
+
+    UINT getWidth();
+    UINT getHeight();
+
+    // Fence value of the last submission that drew into or presented this
+    // view; the back buffers are idle once it completes.
+    void setLastUsedFence(UINT64 value);
+    UINT64 getLastUsedFence();
+
+private:
+    void createSwapChain(IDXGIFactory4* dxgiFactory, ID3D12CommandQueue* commandQueue);
+    void createRenderTargetView();
+    void createBackBufferViews();
+    void createBarriers();
+    void createVpAndSc();
+
+private:
+    static const int bufferCount = 2;
+    int bi{};
+
+    UINT width = 0, height = 0;
+
+    ID3D12Device* device;
+
+    DXGI_SWAP_CHAIN_DESC1 swapChainDesc{};
+    ComPtr<IDXGISwapChain3> swapChain{};
+
+    ComPtr<ID3D12Resource> backBuffers[bufferCount];
+    ComPtr<ID3D12DescriptorHeap> rtvHeap{};
+    D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle[bufferCount];
+
+    D3D12_RESOURCE_BARRIER rtvToPresentBarrier[bufferCount];
+    D3D12_RESOURCE_BARRIER presentToRTVBarrier[bufferCount];
+
+    D3D12_VIEWPORT vp{};
+    D3D12_RECT sc{};
+
+    Camera camera{};
+
+    UINT dirtyFlags = DirtyWindow;
+
+    // Region each back buffer still has to redraw to catch up with the
+    // latest scene, and the region changed since the last present.
+    RECT bufferDamage[bufferCount]{};
+    RECT frameDamage{};
+
+    UINT64 lastUsedFence = 0;
+
+    HWND hwnd;
+};
+
+#endif